@@ -0,0 +1,988 @@
+// Micro-benchmark of src/core/geometry.cpp and its batched variants. Every
+// function runs over a pool of randomized inputs at the scale the game uses
+// (unit cells, body radius 0.5, rays up to a light radius) and reports
+// ns/op and ops/s. A batched op is one element of the batch.
+//
+// The outputs are also cross-checked against straightforward double
+// precision reference implementations. Inputs where the answer flips on
+// rounding (hits at a segment end, tangent lines, near ties) are skipped.
+// The exit code is non-zero if any checked output disagrees.
+
+#include "core/geometry.hpp"
+#include "core/geometry_batch.hpp"
+#include "json.hpp"
+#include "raylib.h"
+#include "raymath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// -----------------------------------------------------------------------
+// config
+struct Config {
+    uint32_t n_ops = 200000;
+    uint32_t seed = 0;
+    std::string out_file_path;
+};
+
+static Config parse_args(int argc, char **argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> uint32_t {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return std::stoul(argv[++i]);
+        };
+
+        if (arg == "--ops") config.n_ops = next();
+        else if (arg == "--seed") config.seed = next();
+        else if (arg == "--out" && i + 1 < argc) config.out_file_path = argv[++i];
+        else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            std::exit(1);
+        }
+    }
+
+    return config;
+}
+
+// -----------------------------------------------------------------------
+// stats
+struct Stat {
+    uint64_t total_ns = 0;
+    uint64_t n_ops = 0;
+    uint64_t n_checked = 0;
+    uint64_t n_skipped = 0;
+    uint64_t n_mismatches = 0;
+
+    json to_json() {
+        double ns_per_op = n_ops ? (double)total_ns / n_ops : 0.0;
+        return {
+            {"total_ns", total_ns},
+            {"n_ops", n_ops},
+            {"ns_per_op", ns_per_op},
+            {"ops_per_second", ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0},
+            {"n_checked", n_checked},
+            {"n_skipped", n_skipped},
+            {"n_mismatches", n_mismatches}};
+    }
+};
+
+// Result of a reference: the expected values, or skipped if ambiguous
+struct Expected {
+    bool is_ambiguous = false;
+    std::vector<double> values;
+};
+
+static constexpr uint32_t n_inputs = 4096;
+static constexpr double tolerance = 1e-3;
+static constexpr double edge_eps = 1e-4;
+
+// Sink of the timed outputs, so the calls can't be optimized out
+static volatile float sink;
+
+// Compares get_values(input_idx) with reference(input_idx) on every input
+static void check_case(
+    Stat &stat,
+    std::function<std::vector<double>(uint32_t)> get_values,
+    std::function<Expected(uint32_t)> reference
+) {
+    for (uint32_t idx = 0; idx < n_inputs; ++idx) {
+        Expected expected = reference(idx);
+        if (expected.is_ambiguous) {
+            stat.n_skipped += 1;
+            continue;
+        }
+
+        std::vector<double> values = get_values(idx);
+        bool is_match = values.size() == expected.values.size();
+        for (uint32_t i = 0; is_match && i < values.size(); ++i) {
+            double diff = std::fabs(values[i] - expected.values[i]);
+            is_match = diff <= tolerance * std::max(1.0, std::fabs(expected.values[i]));
+        }
+        stat.n_checked += 1;
+        stat.n_mismatches += !is_match;
+    }
+}
+
+// Times func(input_idx) over n_ops calls cycling through the inputs, then
+// checks the outputs
+static Stat run_case(
+    uint32_t n_ops,
+    std::function<float(uint32_t)> func,
+    std::function<std::vector<double>(uint32_t)> get_values,
+    std::function<Expected(uint32_t)> reference
+) {
+    Stat stat;
+    float acc = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n_ops; ++i) acc += func(i % n_inputs);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = acc;
+    stat.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    stat.n_ops = n_ops;
+
+    check_case(stat, get_values, reference);
+    return stat;
+}
+
+// Batched variant: one batch() call covers every input, an op is one
+// element of the batch
+static Stat run_batch_case(
+    uint32_t n_ops,
+    std::function<float()> batch,
+    std::function<std::vector<double>(uint32_t)> get_values,
+    std::function<Expected(uint32_t)> reference
+) {
+    Stat stat;
+    uint32_t n_batches = std::max(1u, n_ops / n_inputs);
+    float acc = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n_batches; ++i) acc += batch();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = acc;
+    stat.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    stat.n_ops = (uint64_t)n_batches * n_inputs;
+
+    check_case(stat, get_values, reference);
+    return stat;
+}
+
+// -----------------------------------------------------------------------
+// references
+struct DVec {
+    double x;
+    double y;
+};
+
+static DVec to_dvec(Vector2 v) {
+    return {v.x, v.y};
+}
+
+static DVec sub(DVec a, DVec b) {
+    return {a.x - b.x, a.y - b.y};
+}
+
+static double dot(DVec a, DVec b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+static double cross(DVec a, DVec b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static double length(DVec a) {
+    return std::sqrt(dot(a, a));
+}
+
+// Segment-segment hit as the parameter along the first one, -1 for a miss.
+// Ambiguous if the segments are near parallel or the hit is near an end
+static double ref_segment_hit(
+    DVec start0, DVec end0, DVec start1, DVec end1, bool *is_ambiguous
+) {
+    DVec d0 = sub(end0, start0);
+    DVec d1 = sub(end1, start1);
+    DVec r = sub(start1, start0);
+    double c = cross(d0, d1);
+    if (std::fabs(c) < 1e-3) {
+        *is_ambiguous |= std::fabs(c) > 1e-7;
+        return -1.0;
+    }
+
+    double t0 = cross(r, d1) / c;
+    double t1 = cross(r, d0) / c;
+    for (double t : {t0, t1}) {
+        *is_ambiguous |= std::fabs(t) < edge_eps || std::fabs(t - 1.0) < edge_eps;
+    }
+
+    return t0 >= 0.0 && t0 <= 1.0 && t1 >= 0.0 && t1 <= 1.0 ? t0 : -1.0;
+}
+
+// Minimal translation pushing the circle out of the convex polygon
+static Expected ref_circle_polygon_mtv(
+    Vector2 position, float radius, const Vector2 *vertices, int n
+) {
+    DVec c = to_dvec(position);
+    DVec centroid = {0.0, 0.0};
+    for (int i = 0; i < n; ++i) {
+        centroid.x += vertices[i].x / n;
+        centroid.y += vertices[i].y / n;
+    }
+
+    // Float edge normals of very short edges are too rough to compare
+    bool is_degenerate = false;
+    bool is_inside = true;
+    double nearest_dist = HUGE_VAL;
+    DVec nearest_point = {0.0, 0.0};
+    std::vector<double> pushes;
+    std::vector<DVec> normals;
+    for (int i = 0; i < n; ++i) {
+        DVec v0 = to_dvec(vertices[i]);
+        DVec v1 = to_dvec(vertices[(i + 1) % n]);
+        DVec edge = sub(v1, v0);
+        double len = length(edge);
+        is_degenerate |= len < 1e-2;
+        DVec normal = {edge.y / len, -edge.x / len};
+        if (dot(sub(v0, centroid), normal) < 0.0) normal = {-normal.x, -normal.y};
+
+        double side = dot(sub(c, v0), normal);
+        is_inside &= side < 0.0;
+        pushes.push_back(radius - side);
+        normals.push_back(normal);
+
+        double t = std::clamp(dot(sub(c, v0), edge) / (len * len), 0.0, 1.0);
+        DVec point = {v0.x + t * edge.x, v0.y + t * edge.y};
+        double dist = length(sub(c, point));
+        if (dist < nearest_dist) {
+            nearest_dist = dist;
+            nearest_point = point;
+        }
+    }
+
+    Expected expected;
+    if (is_inside) {
+        // Out through the nearest edge, ties have no single answer
+        std::vector<double> sorted = pushes;
+        std::sort(sorted.begin(), sorted.end());
+        expected.is_ambiguous = sorted[1] - sorted[0] < edge_eps || is_degenerate;
+
+        int best = std::min_element(pushes.begin(), pushes.end()) - pushes.begin();
+        expected.values = {
+            normals[best].x * pushes[best], normals[best].y * pushes[best]};
+        return expected;
+    }
+
+    expected.is_ambiguous = std::fabs(nearest_dist - radius) < edge_eps
+                            || nearest_dist < edge_eps || is_degenerate;
+    if (nearest_dist >= radius) {
+        expected.values = {0.0, 0.0};
+        return expected;
+    }
+
+    // The separating axis test may pick another axis with a tied overlap:
+    // a far edge normal nearly parallel to the vertex direction
+    DVec dir = sub(c, nearest_point);
+    for (const DVec &normal : normals) {
+        double min = HUGE_VAL, max = -HUGE_VAL;
+        for (int i = 0; i < n; ++i) {
+            double k = dot(to_dvec(vertices[i]), normal);
+            min = std::min(min, k);
+            max = std::max(max, k);
+        }
+        double k = dot(c, normal);
+        double overlap = std::min(max - (k - radius), (k + radius) - min);
+        bool is_parallel = dot(dir, normal) > nearest_dist * (1.0 - 1e-9);
+        expected.is_ambiguous |= !is_parallel
+                                 && overlap - (radius - nearest_dist) < edge_eps;
+    }
+
+    double push = (radius - nearest_dist) / nearest_dist;
+    expected.values = {dir.x * push, dir.y * push};
+    return expected;
+}
+
+// -----------------------------------------------------------------------
+// inputs
+struct Line {
+    Vector2 start;
+    Vector2 end;
+};
+
+struct Polygon {
+    Vector2 vertices[8];
+    int n;
+};
+
+// Structure of arrays backing a SegmentBatch
+struct SegmentArrays {
+    std::vector<float> start_xs;
+    std::vector<float> start_ys;
+    std::vector<float> end_xs;
+    std::vector<float> end_ys;
+
+    void push_back(Line line) {
+        start_xs.push_back(line.start.x);
+        start_ys.push_back(line.start.y);
+        end_xs.push_back(line.end.x);
+        end_ys.push_back(line.end.y);
+    }
+
+    SegmentBatch get_batch() const {
+        return {start_xs, start_ys, end_xs, end_ys};
+    }
+};
+
+struct Inputs {
+    std::vector<float> angles;
+    std::vector<Vector2> vecs;
+    std::vector<Vector2> positions;
+    std::vector<Vector2> other_positions;
+    std::vector<Rectangle> rects;
+    std::vector<Polygon> polygons;
+    std::vector<Line> lines;
+    std::vector<Line> other_lines;
+    std::vector<Pivot> pivots;
+    std::vector<std::vector<Segment>> segment_sets;
+};
+
+// Bodies (radius 0.5) near cells or merged wall rects, rays of a few
+// cells, convex polygons of a cell's size
+static Inputs generate_inputs(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit_dist(0.0, 1.0);
+    std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI);
+    std::uniform_real_distribution<float> offset_dist(-1.5, 1.5);
+    std::uniform_real_distribution<float> world_dist(-50.0, 50.0);
+    std::uniform_int_distribution<int> size_dist(1, 16);
+    std::uniform_int_distribution<int> n_vertices_dist(3, 8);
+    std::uniform_int_distribution<int> pivot_dist(0, 5);
+    std::uniform_int_distribution<int> cell_dist(-8, 7);
+
+    Inputs inputs;
+    for (uint32_t i = 0; i < n_inputs; ++i) {
+        Vector2 center = {world_dist(rng), world_dist(rng)};
+
+        inputs.angles.push_back(angle_dist(rng));
+        inputs.vecs.push_back({offset_dist(rng), offset_dist(rng)});
+        inputs.positions.push_back(
+            {center.x + offset_dist(rng), center.y + offset_dist(rng)}
+        );
+        inputs.other_positions.push_back(
+            {center.x + offset_dist(rng), center.y + offset_dist(rng)}
+        );
+
+        float width = unit_dist(rng) < 0.5 ? 1.0 : (float)size_dist(rng);
+        float height = unit_dist(rng) < 0.5 ? 1.0 : (float)size_dist(rng);
+        inputs.rects.push_back(
+            {.x = std::floor(center.x) - std::floor(unit_dist(rng) * width),
+             .y = std::floor(center.y) - std::floor(unit_dist(rng) * height),
+             .width = width,
+             .height = height}
+        );
+
+        // Convex: points on a circle in the angle order
+        Polygon polygon;
+        polygon.n = n_vertices_dist(rng);
+        std::vector<float> angles;
+        for (int j = 0; j < polygon.n; ++j) angles.push_back(angle_dist(rng));
+        std::sort(angles.begin(), angles.end());
+        float poly_radius = 0.5f + unit_dist(rng);
+        for (int j = 0; j < polygon.n; ++j) {
+            polygon.vertices[j] = {
+                center.x + poly_radius * std::cos(angles[j]),
+                center.y + poly_radius * std::sin(angles[j])};
+        }
+        inputs.polygons.push_back(polygon);
+
+        float ray_length = 10.0f * unit_dist(rng);
+        float ray_angle = angle_dist(rng);
+        Vector2 ray_start = {center.x + offset_dist(rng), center.y + offset_dist(rng)};
+        inputs.lines.push_back(
+            {ray_start,
+             {ray_start.x + ray_length * std::cos(ray_angle),
+              ray_start.y + ray_length * std::sin(ray_angle)}}
+        );
+        inputs.other_lines.push_back(
+            {{center.x + offset_dist(rng), center.y + offset_dist(rng)},
+             {center.x + offset_dist(rng), center.y + offset_dist(rng)}}
+        );
+        inputs.pivots.push_back((Pivot)pivot_dist(rng));
+    }
+
+    // Visibility: unit wall edges on the grid around the light. Kept in a
+    // smaller pool, the sweep is a lot slower than the other calls
+    for (uint32_t i = 0; i < 64; ++i) {
+        std::vector<Segment> segments;
+        for (int j = 0; j < 32; ++j) {
+            Vector2 start = {(float)cell_dist(rng), (float)cell_dist(rng)};
+            Vector2 end = start;
+            if (unit_dist(rng) < 0.5) end.x += 1.0;
+            else end.y += 1.0;
+            segments.push_back({start, end});
+        }
+        inputs.segment_sets.push_back(segments);
+    }
+
+    return inputs;
+}
+
+// -----------------------------------------------------------------------
+// cases
+int main(int argc, char **argv) {
+    Config config = parse_args(argc, argv);
+    Inputs in = generate_inputs(config.seed);
+    float radius = 0.5;
+    uint32_t n_ops = config.n_ops;
+    std::vector<std::pair<std::string, Stat>> stats;
+
+    auto add = [&](std::string name, Stat stat) { stats.push_back({name, stat}); };
+    auto vec_values = [](Vector2 v) { return std::vector<double>{v.x, v.y}; };
+
+    // -------------------------------------------------------------------
+    // vectors
+    add("get_orientation_vec",
+        run_case(
+            n_ops,
+            [&](uint32_t i) { return get_orientation_vec(in.angles[i]).x; },
+            [&](uint32_t i) { return vec_values(get_orientation_vec(in.angles[i])); },
+            [&](uint32_t i) {
+                double angle = in.angles[i];
+                return Expected{.values = {std::cos(angle), std::sin(angle)}};
+            }
+        ));
+
+    add("get_vec_orientation",
+        run_case(
+            n_ops,
+            [&](uint32_t i) { return get_vec_orientation(in.vecs[i]); },
+            [&](uint32_t i) {
+                return std::vector<double>{get_vec_orientation(in.vecs[i])};
+            },
+            [&](uint32_t i) {
+                DVec v = to_dvec(in.vecs[i]);
+                // The branch cut at +-pi flips on the sign of a zero
+                bool is_ambiguous = v.x < 0.0 && std::fabs(v.y) < edge_eps;
+                return Expected{is_ambiguous, {std::atan2(v.y, v.x)}};
+            }
+        ));
+
+    add("rotate_vec_90",
+        run_case(
+            n_ops,
+            [&](uint32_t i) { return rotate_vec_90(in.vecs[i]).x; },
+            [&](uint32_t i) { return vec_values(rotate_vec_90(in.vecs[i])); },
+            [&](uint32_t i) {
+                return Expected{.values = {-in.vecs[i].y, in.vecs[i].x}};
+            }
+        ));
+
+    add("flip_vec",
+        run_case(
+            n_ops,
+            [&](uint32_t i) { return flip_vec(in.vecs[i]).x; },
+            [&](uint32_t i) { return vec_values(flip_vec(in.vecs[i])); },
+            [&](uint32_t i) {
+                return Expected{.values = {-in.vecs[i].x, -in.vecs[i].y}};
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // mtv
+    add("get_circle_polygon_mtv",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Polygon &p = in.polygons[i];
+                return get_circle_polygon_mtv(in.positions[i], radius, p.vertices, p.n).x;
+            },
+            [&](uint32_t i) {
+                Polygon &p = in.polygons[i];
+                return vec_values(
+                    get_circle_polygon_mtv(in.positions[i], radius, p.vertices, p.n)
+                );
+            },
+            [&](uint32_t i) {
+                Polygon &p = in.polygons[i];
+                return ref_circle_polygon_mtv(in.positions[i], radius, p.vertices, p.n);
+            }
+        ));
+
+    auto ref_circle_circle_mtv = [&](Vector2 position0, Vector2 position1) {
+        DVec d = sub(to_dvec(position1), to_dvec(position0));
+        double dist = length(d);
+        Expected expected = {.values = {0.0, 0.0}};
+        expected.is_ambiguous = std::fabs(dist - 2.0 * radius) < edge_eps;
+        if (dist < 2.0 * radius) {
+            double push = (dist - 2.0 * radius) / dist;
+            expected.values = {d.x * push, d.y * push};
+        }
+        return expected;
+    };
+    add("get_circle_circle_mtv",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                return get_circle_circle_mtv(
+                           in.positions[i], radius, in.other_positions[i], radius
+                )
+                    .x;
+            },
+            [&](uint32_t i) {
+                return vec_values(get_circle_circle_mtv(
+                    in.positions[i], radius, in.other_positions[i], radius
+                ));
+            },
+            [&](uint32_t i) {
+                return ref_circle_circle_mtv(in.positions[i], in.other_positions[i]);
+            }
+        ));
+
+    add("get_circle_rect_mtv",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                return get_circle_rect_mtv(in.positions[i], radius, in.rects[i]).x;
+            },
+            [&](uint32_t i) {
+                return vec_values(
+                    get_circle_rect_mtv(in.positions[i], radius, in.rects[i])
+                );
+            },
+            [&](uint32_t i) {
+                Rectangle r = in.rects[i];
+                Vector2 vertices[4] = {
+                    {r.x, r.y},
+                    {r.x + r.width, r.y},
+                    {r.x + r.width, r.y + r.height},
+                    {r.x, r.y + r.height}};
+                return ref_circle_polygon_mtv(in.positions[i], radius, vertices, 4);
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // intersections
+    auto line_line_values = [&](uint32_t i) {
+        Vector2 point;
+        Line a = in.lines[i];
+        Line b = in.other_lines[i];
+        if (!get_line_line_intersection(a.start, a.end, b.start, b.end, &point)) {
+            return std::vector<double>{};
+        }
+        return vec_values(point);
+    };
+    add("get_line_line_intersection",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Vector2 point = {0.0, 0.0};
+                Line a = in.lines[i];
+                Line b = in.other_lines[i];
+                return get_line_line_intersection(a.start, a.end, b.start, b.end, &point)
+                       + point.x;
+            },
+            line_line_values,
+            [&](uint32_t i) {
+                Line a = in.lines[i];
+                Line b = in.other_lines[i];
+                Expected expected;
+                DVec start = to_dvec(a.start);
+                DVec d = sub(to_dvec(a.end), start);
+                double t = ref_segment_hit(
+                    start, to_dvec(a.end), to_dvec(b.start), to_dvec(b.end),
+                    &expected.is_ambiguous
+                );
+                if (t >= 0.0) expected.values = {start.x + t * d.x, start.y + t * d.y};
+                return expected;
+            }
+        ));
+
+    // Roots of the segment-circle quadratic in the implementation's order:
+    // the far one first
+    auto ref_line_circle = [&](Line line, Vector2 center, bool is_nearest_only) {
+        DVec start = to_dvec(line.start);
+        DVec d = sub(to_dvec(line.end), start);
+        DVec f = sub(start, to_dvec(center));
+        double a = dot(d, d);
+        double b = 2.0 * dot(d, f);
+        double c = dot(f, f) - (double)radius * radius;
+        double det = b * b - 4.0 * a * c;
+
+        Expected expected;
+        expected.is_ambiguous = std::fabs(det) < 1e-3 * a || a < 1e-6;
+        if (det < 0.0) return expected;
+
+        std::vector<double> ts;
+        double root = std::sqrt(det);
+        for (double t : {(-b + root) / (2.0 * a), (-b - root) / (2.0 * a)}) {
+            expected.is_ambiguous |= std::fabs(t) < edge_eps
+                                     || std::fabs(t - 1.0) < edge_eps;
+            if (t >= 0.0 && t <= 1.0) ts.push_back(t);
+        }
+        if (is_nearest_only && ts.size() == 2) ts = {std::min(ts[0], ts[1])};
+        for (double t : ts) {
+            expected.values.push_back(start.x + t * d.x);
+            expected.values.push_back(start.y + t * d.y);
+        }
+        return expected;
+    };
+    add("get_line_circle_intersections",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Vector2 points[2] = {{0.0, 0.0}, {0.0, 0.0}};
+                return get_line_circle_intersections(
+                           in.lines[i].start,
+                           in.lines[i].end,
+                           in.other_positions[i],
+                           radius,
+                           points
+                       )
+                       + points[0].x;
+            },
+            [&](uint32_t i) {
+                Vector2 points[2];
+                int n = get_line_circle_intersections(
+                    in.lines[i].start,
+                    in.lines[i].end,
+                    in.other_positions[i],
+                    radius,
+                    points
+                );
+                std::vector<double> values;
+                for (int j = 0; j < n; ++j) {
+                    values.push_back(points[j].x);
+                    values.push_back(points[j].y);
+                }
+                return values;
+            },
+            [&](uint32_t i) {
+                return ref_line_circle(in.lines[i], in.other_positions[i], false);
+            }
+        ));
+
+    add("get_line_circle_intersection_nearest",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Vector2 point = {0.0, 0.0};
+                return get_line_circle_intersection_nearest(
+                           in.lines[i].start,
+                           in.lines[i].end,
+                           in.other_positions[i],
+                           radius,
+                           &point
+                       )
+                       + point.x;
+            },
+            [&](uint32_t i) {
+                Vector2 point;
+                int n = get_line_circle_intersection_nearest(
+                    in.lines[i].start,
+                    in.lines[i].end,
+                    in.other_positions[i],
+                    radius,
+                    &point
+                );
+                return n ? vec_values(point) : std::vector<double>{};
+            },
+            [&](uint32_t i) {
+                return ref_line_circle(in.lines[i], in.other_positions[i], true);
+            }
+        ));
+
+    // Nearest hit of the ray on the polygon's (or rect's) edges
+    auto ref_line_polygon = [&](Line line, const Vector2 *vertices, int n) {
+        DVec start = to_dvec(line.start);
+        DVec d = sub(to_dvec(line.end), start);
+        Expected expected;
+        double nearest_t = HUGE_VAL;
+        for (int j = 0; j < n; ++j) {
+            double t = ref_segment_hit(
+                start,
+                to_dvec(line.end),
+                to_dvec(vertices[j]),
+                to_dvec(vertices[(j + 1) % n]),
+                &expected.is_ambiguous
+            );
+            if (t >= 0.0) nearest_t = std::min(nearest_t, t);
+        }
+        if (nearest_t < HUGE_VAL) {
+            expected.values = {start.x + nearest_t * d.x, start.y + nearest_t * d.y};
+        }
+        return expected;
+    };
+    auto get_rect_vertices = [&](Rectangle r, Vector2 vertices[4]) {
+        vertices[0] = {r.x, r.y};
+        vertices[1] = {r.x + r.width, r.y};
+        vertices[2] = {r.x + r.width, r.y + r.height};
+        vertices[3] = {r.x, r.y + r.height};
+    };
+
+    add("get_line_polygon_intersection_nearest",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Vector2 point = {0.0, 0.0};
+                Polygon &p = in.polygons[i];
+                return get_line_polygon_intersection_nearest(
+                           in.lines[i].start, in.lines[i].end, p.vertices, p.n, &point
+                       )
+                       + point.x;
+            },
+            [&](uint32_t i) {
+                Vector2 point;
+                Polygon &p = in.polygons[i];
+                int n = get_line_polygon_intersection_nearest(
+                    in.lines[i].start, in.lines[i].end, p.vertices, p.n, &point
+                );
+                return n ? vec_values(point) : std::vector<double>{};
+            },
+            [&](uint32_t i) {
+                return ref_line_polygon(
+                    in.lines[i], in.polygons[i].vertices, in.polygons[i].n
+                );
+            }
+        ));
+
+    add("get_line_rect_intersection_nearest",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                Vector2 point = {0.0, 0.0};
+                return get_line_rect_intersection_nearest(
+                           in.lines[i].start, in.lines[i].end, in.rects[i], &point
+                       )
+                       + point.x;
+            },
+            [&](uint32_t i) {
+                Vector2 point;
+                int n = get_line_rect_intersection_nearest(
+                    in.lines[i].start, in.lines[i].end, in.rects[i], &point
+                );
+                return n ? vec_values(point) : std::vector<double>{};
+            },
+            [&](uint32_t i) {
+                Vector2 vertices[4];
+                get_rect_vertices(in.rects[i], vertices);
+                return ref_line_polygon(in.lines[i], vertices, 4);
+            }
+        ));
+
+    add("check_point_in_rect",
+        run_case(
+            n_ops,
+            [&](uint32_t i) { return check_point_in_rect(in.positions[i], in.rects[i]); },
+            [&](uint32_t i) {
+                return std::vector<double>{
+                    (double)check_point_in_rect(in.positions[i], in.rects[i])};
+            },
+            [&](uint32_t i) {
+                DVec p = to_dvec(in.positions[i]);
+                Rectangle r = in.rects[i];
+                bool is_inside = p.x >= r.x && p.x < (double)r.x + r.width && p.y >= r.y
+                                 && p.y < (double)r.y + r.height;
+                return Expected{.values = {(double)is_inside}};
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // visibility
+    // No closed form to compare with: the check is that no vertex of the
+    // polygon lies behind a segment as seen from the origin
+    uint32_t n_segment_sets = in.segment_sets.size();
+    std::vector<Vector2> vertices;
+    float light_radius = 10.0;
+    add("get_visibility_polygon",
+        run_case(
+            std::max(1u, n_ops / 100),
+            [&](uint32_t i) {
+                Vector2 origin = {in.vecs[i].x, in.vecs[i].y};
+                get_visibility_polygon(
+                    origin, light_radius, in.segment_sets[i % n_segment_sets], vertices
+                );
+                return vertices.size();
+            },
+            [&](uint32_t i) {
+                Vector2 origin = {in.vecs[i].x, in.vecs[i].y};
+                const std::vector<Segment> &segments
+                    = in.segment_sets[i % n_segment_sets];
+                get_visibility_polygon(origin, light_radius, segments, vertices);
+
+                uint32_t n_occluded = 0;
+                for (Vector2 vertex : vertices) {
+                    DVec o = to_dvec(origin);
+                    DVec v = to_dvec(vertex);
+                    DVec d = sub(v, o);
+                    for (const Segment &segment : segments) {
+                        DVec s = to_dvec(segment.start);
+                        DVec e = sub(to_dvec(segment.end), s);
+                        double c = cross(d, e);
+                        if (std::fabs(c) < 1e-9) continue;
+                        double t = cross(sub(s, o), e) / c;
+                        double u = cross(sub(s, o), d) / c;
+                        n_occluded += t > 1e-3 && t < 1.0 - 1e-3 && u > 1e-3
+                                      && u < 1.0 - 1e-3;
+                    }
+                }
+                return std::vector<double>{(double)vertices.size(), (double)n_occluded};
+            },
+            [&](uint32_t i) {
+                uint32_t n_segments = in.segment_sets[i % n_segment_sets].size();
+                double n_rays = 3.0 * (4 + 2 * n_segments);
+                return Expected{.values = {n_rays, 0.0}};
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // rects
+    add("get_rect_from_pivot",
+        run_case(
+            n_ops,
+            [&](uint32_t i) {
+                return get_rect_from_pivot(in.positions[i], in.pivots[i], 1.0, 2.0).x;
+            },
+            [&](uint32_t i) {
+                Rectangle r
+                    = get_rect_from_pivot(in.positions[i], in.pivots[i], 1.0, 2.0);
+                return std::vector<double>{r.x, r.y, r.width, r.height};
+            },
+            [&](uint32_t i) {
+                static const double offsets[6][2] = {
+                    {-0.5, -1.0},  // CENTER_BOTTOM
+                    {-0.5, 0.0},  // CENTER_TOP
+                    {0.0, -0.5},  // LEFT_CENTER
+                    {0.0, -1.0},  // LEFT_BOTTOM
+                    {-1.0, -0.5},  // RIGHT_CENTER
+                    {-0.5, -0.5},  // CENTER_CENTER
+                };
+                const double *offset = offsets[(int)in.pivots[i]];
+                DVec p = to_dvec(in.positions[i]);
+                return Expected{
+                    .values = {p.x + offset[0] * 1.0, p.y + offset[1] * 2.0, 1.0, 2.0}};
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // batches
+    // Many bodies against one shape: every input is moved next to the shape
+    // of the first one, keeping its offset from its own shape
+    Vector2 batch_position = in.other_positions[0];
+    Rectangle batch_rect = in.rects[0];
+    auto move_line = [](Line line, float dx, float dy) {
+        return Line{
+            {line.start.x + dx, line.start.y + dy}, {line.end.x + dx, line.end.y + dy}};
+    };
+
+    std::vector<Line> circle_lines;
+    std::vector<Line> rect_lines;
+    SegmentArrays circle_segments;
+    SegmentArrays rect_segments;
+    std::vector<float> body_xs;
+    std::vector<float> body_ys;
+    std::vector<float> body_radii(n_inputs, radius);
+    for (uint32_t i = 0; i < n_inputs; ++i) {
+        Vector2 offset = Vector2Subtract(batch_position, in.other_positions[i]);
+        circle_lines.push_back(move_line(in.lines[i], offset.x, offset.y));
+        circle_segments.push_back(circle_lines.back());
+        body_xs.push_back(in.positions[i].x + offset.x);
+        body_ys.push_back(in.positions[i].y + offset.y);
+
+        Rectangle rect = in.rects[i];
+        rect_lines.push_back(
+            move_line(in.lines[i], batch_rect.x - rect.x, batch_rect.y - rect.y)
+        );
+        rect_segments.push_back(rect_lines.back());
+    }
+
+    std::vector<uint8_t> hits(n_inputs);
+    std::vector<float> dists(n_inputs);
+    std::vector<float> mtv_xs(n_inputs);
+    std::vector<float> mtv_ys(n_inputs);
+    auto dist_values = [&](uint32_t i) {
+        return hits[i] ? std::vector<double>{dists[i]} : std::vector<double>{};
+    };
+
+    // The expected hit point as the distance from the segment start
+    auto to_dist = [](Line line, Expected expected) {
+        if (!expected.values.empty()) {
+            DVec point = {expected.values[0], expected.values[1]};
+            expected.values = {length(sub(point, to_dvec(line.start)))};
+        }
+        return expected;
+    };
+
+    add("get_segments_circle_hits",
+        run_batch_case(
+            n_ops,
+            [&]() {
+                get_segments_circle_hits(
+                    circle_segments.get_batch(), batch_position, radius, hits, dists
+                );
+                return hits[0] + dists[0];
+            },
+            dist_values,
+            [&](uint32_t i) {
+                Line line = circle_lines[i];
+                return to_dist(line, ref_line_circle(line, batch_position, true));
+            }
+        ));
+
+    add("get_segments_rect_hits",
+        run_batch_case(
+            n_ops,
+            [&]() {
+                get_segments_rect_hits(
+                    rect_segments.get_batch(), batch_rect, hits, dists
+                );
+                return hits[0] + dists[0];
+            },
+            dist_values,
+            [&](uint32_t i) {
+                Vector2 vertices[4];
+                get_rect_vertices(batch_rect, vertices);
+                Line line = rect_lines[i];
+                return to_dist(line, ref_line_polygon(line, vertices, 4));
+            }
+        ));
+
+    add("get_circles_circle_mtvs",
+        run_batch_case(
+            n_ops,
+            [&]() {
+                get_circles_circle_mtvs(
+                    {body_xs, body_ys, body_radii},
+                    batch_position,
+                    radius,
+                    hits,
+                    mtv_xs,
+                    mtv_ys
+                );
+                return mtv_xs[0];
+            },
+            [&](uint32_t i) { return std::vector<double>{mtv_xs[i], mtv_ys[i]}; },
+            [&](uint32_t i) {
+                return ref_circle_circle_mtv({body_xs[i], body_ys[i]}, batch_position);
+            }
+        ));
+
+    // -------------------------------------------------------------------
+    // report
+    json cases = json::object();
+    uint64_t n_mismatches = 0;
+    for (auto &[name, stat] : stats) {
+        cases[name] = stat.to_json();
+        n_mismatches += stat.n_mismatches;
+    }
+
+    json report = {
+        {"config",
+         {{"ops", config.n_ops},
+          {"seed", config.seed},
+          {"inputs", n_inputs},
+          {"batch_simd", is_geometry_batch_simd()}}},
+        {"cases", cases},
+        {"n_mismatches", n_mismatches}};
+
+    if (config.out_file_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream file(config.out_file_path);
+        file << report.dump(2) << std::endl;
+    }
+
+    return n_mismatches ? 1 : 0;
+}
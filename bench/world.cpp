@@ -0,0 +1,491 @@
+// Entity-scale stress benchmark of the world systems.
+//
+// Populates a world with the requested number of walls, doors and colliding
+// agents, runs the update systems headless for N ticks and prints per-system
+// timings (ns/tick, ns/entity) and heap allocations as JSON:
+//
+//     ./build/linux/the_shell_bench --walls 100000 --doors 10000 --agents 100000
+//
+// Use --followers N to make the first N agents route through a flow field,
+// --viewers N and --lights N to give them a field of view or a light.
+//
+// Pass --draw to also measure draw_renderables (opens a hidden window).
+#include "core/animation.hpp"
+#include "core/geometry.hpp"
+#include "core/grid_ray.hpp"
+#include "core/renderer.hpp"
+#include "core/thread_pool.hpp"
+#include "game.hpp"
+#include "input_stream.hpp"
+#include "json.hpp"
+#include "raylib.h"
+#include "raymath.h"
+#include "world.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using json = nlohmann::json;
+using namespace the_shell;
+
+// -----------------------------------------------------------------------
+// allocations
+// The replaced operators pair malloc/free by design
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static std::atomic<uint64_t> n_allocs{0};
+
+void *operator new(size_t size) {
+    n_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// -----------------------------------------------------------------------
+// config
+struct Config {
+    uint32_t n_walls = 1000;
+    uint32_t n_doors = 100;
+    uint32_t n_agents = 1000;
+    uint32_t n_followers = 0;
+    uint32_t n_viewers = 0;
+    uint32_t n_lights = 0;
+    uint32_t n_ticks = 100;
+    uint32_t n_queries = 1000;
+    uint32_t n_paths = 100;
+    uint32_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t seed = 0;
+    bool draw = false;
+    std::string out_file_path;
+    std::string replay_file_path;
+};
+
+static Config parse_args(int argc, char **argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> uint32_t {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return std::stoul(argv[++i]);
+        };
+
+        if (arg == "--walls") config.n_walls = next();
+        else if (arg == "--doors") config.n_doors = next();
+        else if (arg == "--agents") config.n_agents = next();
+        else if (arg == "--followers") config.n_followers = next();
+        else if (arg == "--viewers") config.n_viewers = next();
+        else if (arg == "--lights") config.n_lights = next();
+        else if (arg == "--ticks") config.n_ticks = next();
+        else if (arg == "--queries") config.n_queries = next();
+        else if (arg == "--paths") config.n_paths = next();
+        else if (arg == "--threads") config.n_threads = next();
+        else if (arg == "--seed") config.seed = next();
+        else if (arg == "--draw") config.draw = true;
+        else if (arg == "--out" && i + 1 < argc) config.out_file_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) config.replay_file_path = argv[++i];
+        else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            std::exit(1);
+        }
+    }
+
+    return config;
+}
+
+// -----------------------------------------------------------------------
+// world population
+struct Population {
+    uint32_t n_walls = 0;
+    uint32_t n_doors = 0;
+    uint32_t n_agents = 0;
+    uint32_t n_followers = 0;
+    uint32_t n_viewers = 0;
+    uint32_t n_lights = 0;
+};
+
+// Walls are laid out as horizontal lines on every 4th row, doors are spread
+// evenly inside the lines and agents are scattered between them, slightly
+// overlapping the walls so the collision system has work to do. The first
+// n_followers agents route to the world center through the flow field, the
+// first n_viewers agents compute their field of view and the first n_lights
+// agents carry a light
+static Population populate(World &world, uint32_t side, Config &config) {
+    Population population;
+    std::mt19937 rng(config.seed);
+
+    uint32_t n_line_cells = config.n_walls + config.n_doors;
+    uint32_t door_step = config.n_doors ? std::max(1u, n_line_cells / config.n_doors)
+                                        : 0;
+
+    Item wall(ItemType::WALL, sheet_0::wall);
+    Item door(ItemType::DOOR, sheet_0::door);
+
+    uint32_t n_placed = 0;
+    for (int32_t row = 1; row < (int32_t)side - 1 && n_placed < n_line_cells;
+         row += 4) {
+        for (int32_t col = 1; col < (int32_t)side - 1 && n_placed < n_line_cells;
+             ++col) {
+            world.set_cell_item({row, col}, wall);
+            n_placed += 1;
+        }
+    }
+
+    n_placed = 0;
+    for (int32_t row = 1; row < (int32_t)side - 1 && n_placed < n_line_cells;
+         row += 4) {
+        for (int32_t col = 1; col < (int32_t)side - 1 && n_placed < n_line_cells;
+             ++col) {
+            n_placed += 1;
+
+            bool is_line_end = col == 1 || col == (int32_t)side - 2
+                               || n_placed == n_line_cells;
+            bool is_door = door_step && n_placed % door_step == 0
+                           && population.n_doors < config.n_doors;
+            if (is_door && !is_line_end) {
+                world.set_cell_item({row, col}, door);
+                population.n_doors += 1;
+            } else {
+                population.n_walls += 1;
+            }
+        }
+    }
+
+    std::uniform_int_distribution<int32_t> cell_dist(1, side - 2);
+    std::uniform_real_distribution<float> jitter_dist(-0.3, 0.3);
+    for (uint32_t i = 0; i < config.n_agents; ++i) {
+        int32_t row = cell_dist(rng);
+        if (row % 4 == 1) row += 1;
+        int32_t col = cell_dist(rng);
+
+        Vector2 position = world.get_cell_position({row, col});
+        position.x += jitter_dist(rng);
+        position.y += jitter_dist(rng);
+
+        entt::entity entity = world.registry.create();
+        world.registry.emplace<Position_C>(entity, Position_C(position));
+        world.registry.emplace<ResolveCollision_C>(entity);
+        world.registry.emplace<Renderable_C>(
+            entity, Renderable_C::create_circle(0.5, 1.0, BLUE)
+        );
+        population.n_agents += 1;
+
+        if (i < config.n_followers) {
+            CellCoord goal = world.get_cell_coord({0.0, 0.0});
+            world.registry.emplace<FollowFlow_C>(entity, goal, 3.0f, true);
+            population.n_followers += 1;
+        }
+
+        if (i < config.n_viewers) {
+            world.registry.emplace<Vision_C>(entity, Vision_C{.radius = 8, .fov = {}});
+            population.n_viewers += 1;
+        }
+
+        if (i < config.n_lights) {
+            Light_C light = {.radius = 10.0, .color = WHITE, .polygon = {}};
+            world.registry.emplace<Light_C>(entity, light);
+            population.n_lights += 1;
+        }
+    }
+
+    return population;
+}
+
+// -----------------------------------------------------------------------
+// stats
+struct Stat {
+    uint64_t total_ns = 0;
+    uint64_t n_samples = 0;
+    uint64_t n_entities = 0;
+
+    json to_json() {
+        double ns_per_sample = n_samples ? (double)total_ns / n_samples : 0.0;
+        double ns_per_entity = n_entities ? ns_per_sample / n_entities : 0.0;
+        return {
+            {"total_ns", total_ns},
+            {"n_samples", n_samples},
+            {"n_entities", n_entities},
+            {"ns_per_sample", ns_per_sample},
+            {"ns_per_entity", ns_per_entity}};
+    }
+};
+
+static uint64_t get_elapsed_ns(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+int main(int argc, char **argv) {
+    Config config = parse_args(argc, argv);
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::unique_ptr<Renderer> renderer;
+    if (config.draw) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        renderer = std::make_unique<Renderer>(1920, 1080);
+    }
+
+    // A replay runs a recorded session on the game's own (empty) world
+    // instead of the synthetic population, for as many ticks as recorded
+    std::unique_ptr<InputReplay> replay;
+    if (!config.replay_file_path.empty()) {
+        replay = std::make_unique<InputReplay>(config.replay_file_path);
+    }
+
+    uint32_t n_cells = (config.n_walls + config.n_doors) * 4 + config.n_agents;
+    uint32_t side = std::max(32u, (uint32_t)std::ceil(std::sqrt((double)n_cells)) + 2);
+    if (replay) side = grid_n_rows;
+
+    ThreadPool thread_pool(config.n_threads);
+    AnimationTable animation_table("resources/sprites/sheet_16_16.json");
+    World world(side, side, thread_pool, animation_table);
+    Population population;
+    if (replay) {
+        Light_C light = {
+            .radius = player_light_radius, .color = player_light_color, .polygon = {}};
+        world.registry.emplace<Light_C>(world.player, light);
+        population.n_lights = 1;
+    } else {
+        population = populate(world, side, config);
+    }
+
+    // -------------------------------------------------------------------
+    // systems
+    uint32_t n_colliders = world.registry.view<ResolveCollision_C>().size();
+    std::unordered_map<std::string, Stat> system_stats;
+    auto get_n_entities = [&](std::string name) -> uint64_t {
+        if (name == "collisions") return n_colliders;
+        if (name == "player") return 1;
+        if (name == "flow_followers") return population.n_followers;
+        if (name == "visions") return population.n_viewers;
+        if (name == "lights") return population.n_lights;
+        if (name == "doors" || name == "animations") return population.n_doors;
+        return 0;
+    };
+
+    Input input;
+    input.dt = 1.0 / 60.0;
+
+    uint64_t n_update_allocs = 0;
+    Stat update_stat = {.n_entities = n_colliders + population.n_doors};
+    uint32_t n_update_ticks = 0;
+    for (; replay || n_update_ticks < config.n_ticks; ++n_update_ticks) {
+        if (replay && !replay->next(input)) break;
+
+        uint64_t n_allocs_before = n_allocs.load();
+        auto start = std::chrono::steady_clock::now();
+        world.update(input);
+        update_stat.total_ns += get_elapsed_ns(start);
+        update_stat.n_samples += 1;
+        n_update_allocs += n_allocs.load() - n_allocs_before;
+
+        for (SystemTiming timing : world.get_system_timings()) {
+            Stat &stat = system_stats[timing.name];
+            stat.total_ns += timing.ns;
+            stat.n_samples += 1;
+            stat.n_entities = get_n_entities(timing.name);
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // can_place_item
+    // Queries are sampled inside the build radius around the player,
+    // otherwise the function exits before scanning the colliders
+    std::mt19937 rng(config.seed);
+    std::uniform_real_distribution<float> offset_dist(-2.5, 2.5);
+    Vector2 player_position = world.registry.get<Position_C>(world.player);
+
+    Stat can_place_stat = {.n_entities = n_colliders};
+    uint64_t n_can_place_allocs = 0;
+    uint32_t n_can_place = 0;
+    for (uint32_t tick = 0; tick < config.n_ticks; ++tick) {
+        for (uint32_t i = 0; i < config.n_queries; ++i) {
+            Vector2 position = {
+                player_position.x + offset_dist(rng),
+                player_position.y + offset_dist(rng)};
+            position = world.round_position(position);
+            Item *item = world.get_item(i % world.items.size());
+
+            uint64_t n_allocs_before = n_allocs.load();
+            auto start = std::chrono::steady_clock::now();
+            n_can_place += world.can_place_item(item, position);
+            can_place_stat.total_ns += get_elapsed_ns(start);
+            can_place_stat.n_samples += 1;
+            n_can_place_allocs += n_allocs.load() - n_allocs_before;
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // find_path
+    // Every query follows a wall placement or removal somewhere on the map,
+    // so the timings include the path graph repair. The wall lines only
+    // connect at the doors and the map edges, so the abstract search has to
+    // sweep the lines for their doors: the time follows the route length
+    // (reported) more than the map size
+    std::uniform_int_distribution<int32_t> cell_dist(1, side - 2);
+    Item wall(ItemType::WALL, sheet_0::wall);
+    Stat find_path_stat;
+    uint32_t n_paths_found = 0;
+    uint64_t n_path_cells = 0;
+    for (uint32_t i = 0; i < config.n_paths; ++i) {
+        CellCoord coord = {cell_dist(rng), cell_dist(rng)};
+        Cell *cell = world.get_cell(coord);
+        if (cell->item.is_none()) world.set_cell_item(coord, wall);
+        else if (cell->item.is_wall()) world.set_cell_item(coord, Item());
+
+        CellCoord start = {cell_dist(rng), cell_dist(rng)};
+        CellCoord goal = {cell_dist(rng), cell_dist(rng)};
+        auto start_time = std::chrono::steady_clock::now();
+        uint32_t n_cells = world.find_path(start, goal).size();
+        find_path_stat.total_ns += get_elapsed_ns(start_time);
+        n_paths_found += n_cells > 0;
+        n_path_cells += n_cells;
+        find_path_stat.n_samples += 1;
+    }
+
+    // -------------------------------------------------------------------
+    // raycast
+    // One batch of hitscans per tick, from random floor points of the map
+    // in random directions, up to a light radius long
+    std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI);
+    std::vector<Segment> rays(config.n_queries);
+    std::vector<uint8_t> is_hits;
+    std::vector<GridRayHit> hits;
+    Stat raycast_stat = {.n_entities = config.n_queries};
+    uint32_t n_ray_hits = 0;
+    for (uint32_t tick = 0; tick < config.n_ticks; ++tick) {
+        for (Segment &ray : rays) {
+            ray.start = world.get_cell_position({cell_dist(rng), cell_dist(rng)});
+            Vector2 dir = get_orientation_vec(angle_dist(rng));
+            ray.end = Vector2Add(ray.start, Vector2Scale(dir, player_light_radius));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        world.raycast(rays, is_hits, hits);
+        raycast_stat.total_ns += get_elapsed_ns(start);
+        raycast_stat.n_samples += 1;
+        for (uint8_t is_hit : is_hits) n_ray_hits += is_hit;
+    }
+
+    // -------------------------------------------------------------------
+    // save / load
+    // Loads into a fresh world, so every non-empty cell is written back
+    std::string save_path = (std::filesystem::temp_directory_path()
+                             / "the_shell_bench.tsgf")
+                                .string();
+    Stat save_stat;
+    auto save_start = std::chrono::steady_clock::now();
+    world.save(save_path);
+    save_stat.total_ns = get_elapsed_ns(save_start);
+    save_stat.n_samples = 1;
+    uint64_t save_n_bytes = std::filesystem::file_size(save_path);
+
+    Stat load_stat;
+    {
+        World loaded_world(side, side, thread_pool, animation_table);
+        auto load_start = std::chrono::steady_clock::now();
+        loaded_world.load(save_path);
+        load_stat.total_ns = get_elapsed_ns(load_start);
+        load_stat.n_samples = 1;
+    }
+    std::filesystem::remove(save_path);
+
+    // -------------------------------------------------------------------
+    // draw_renderables
+    Stat draw_stat = {.n_entities = n_colliders};
+    if (renderer) {
+        for (uint32_t tick = 0; tick < config.n_ticks; ++tick) {
+            renderer->begin_drawing();
+            renderer->set_camera(player_position, (float)side);
+
+            auto start = std::chrono::steady_clock::now();
+            draw_renderables(*renderer, world.registry);
+            draw_stat.total_ns += get_elapsed_ns(start);
+            draw_stat.n_samples += 1;
+
+            renderer->end_drawing();
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // report
+    json systems = json::object();
+    for (auto &[name, stat] : system_stats) systems[name] = stat.to_json();
+
+    json report = {
+        {"config",
+         {{"walls", config.n_walls},
+          {"doors", config.n_doors},
+          {"agents", config.n_agents},
+          {"followers", config.n_followers},
+          {"viewers", config.n_viewers},
+          {"lights", config.n_lights},
+          {"ticks", config.n_ticks},
+          {"queries", config.n_queries},
+          {"paths", config.n_paths},
+          {"threads", config.n_threads},
+          {"seed", config.seed},
+          {"replay", config.replay_file_path}}},
+        {"world",
+         {{"n_rows", side},
+          {"n_cols", side},
+          {"n_walls", population.n_walls},
+          {"n_doors", population.n_doors},
+          {"n_agents", population.n_agents},
+          {"n_followers", population.n_followers},
+          {"n_viewers", population.n_viewers},
+          {"n_lights", population.n_lights},
+          {"n_colliders", n_colliders},
+          {"n_rooms", world.get_rooms().get_n_rooms()}}},
+        {"update", update_stat.to_json()},
+        {"systems", systems},
+        {"can_place_item", can_place_stat.to_json()},
+        {"find_path", find_path_stat.to_json()},
+        {"raycast", raycast_stat.to_json()},
+        {"save", save_stat.to_json()},
+        {"load", load_stat.to_json()},
+        {"allocations",
+         {{"update_total", n_update_allocs},
+          {"update_per_tick",
+           n_update_ticks ? (double)n_update_allocs / n_update_ticks : 0.0},
+          {"can_place_item_total", n_can_place_allocs}}}};
+    report["can_place_item"]["n_placeable"] = n_can_place;
+    report["find_path"]["n_found"] = n_paths_found;
+    report["find_path"]["mean_path_len"] =
+        n_paths_found ? (double)n_path_cells / n_paths_found : 0.0;
+    report["raycast"]["n_hits"] = n_ray_hits;
+    report["save"]["n_bytes"] = save_n_bytes;
+    if (renderer) report["draw_renderables"] = draw_stat.to_json();
+
+    if (config.out_file_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream file(config.out_file_path);
+        file << report.dump(2) << std::endl;
+    }
+}
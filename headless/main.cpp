@@ -0,0 +1,114 @@
+// Headless simulation: the world systems without a window, GL or input
+// polling. Inputs come from a recorded session (or stay idle), ticks run
+// as fast as possible.
+//
+// Usage: the_shell_headless [--replay <file>] [--ticks <n>] [--load <file>]
+//                           [--save <file>] [--threads <n>]
+//
+// Without --replay the world runs --ticks idle ticks, with it the log
+// runs to its end or to --ticks, whichever comes first.
+
+#include "core/animation.hpp"
+#include "core/thread_pool.hpp"
+#include "input_stream.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace the_shell;
+
+// -----------------------------------------------------------------------
+// config
+struct Config {
+    uint32_t n_ticks = UINT32_MAX;
+    uint32_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string replay_file_path;
+    std::string load_file_path;
+    std::string save_file_path;
+};
+
+static Config parse_args(int argc, char **argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--ticks") config.n_ticks = std::stoul(next());
+        else if (arg == "--threads") config.n_threads = std::stoul(next());
+        else if (arg == "--replay") config.replay_file_path = next();
+        else if (arg == "--load") config.load_file_path = next();
+        else if (arg == "--save") config.save_file_path = next();
+        else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            std::exit(1);
+        }
+    }
+
+    if (config.replay_file_path.empty() && config.n_ticks == UINT32_MAX) {
+        std::fprintf(stderr, "Either --replay or --ticks is required\n");
+        std::exit(1);
+    }
+
+    return config;
+}
+
+int main(int argc, char **argv) {
+    Config config = parse_args(argc, argv);
+
+    try {
+        std::unique_ptr<InputReplay> replay;
+        if (!config.replay_file_path.empty()) {
+            replay = std::make_unique<InputReplay>(config.replay_file_path);
+        }
+
+        // Same world and player as the game sets up
+        ThreadPool thread_pool(config.n_threads);
+        AnimationTable animation_table("resources/sprites/sheet_16_16.json");
+        World world(grid_n_rows, grid_n_cols, thread_pool, animation_table);
+        world.registry.emplace<Light_C>(
+            world.player,
+            Light_C{.radius = player_light_radius, .color = player_light_color}
+        );
+        if (!config.load_file_path.empty()) world.load(config.load_file_path);
+
+        Input input;
+        input.dt = 1.0 / 60.0;
+
+        uint32_t n_ticks = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (; n_ticks < config.n_ticks; ++n_ticks) {
+            if (replay && !replay->next(input)) break;
+            world.update(input);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double seconds = std::chrono::duration<double>(elapsed).count();
+
+        if (!config.save_file_path.empty()) world.save(config.save_file_path);
+
+        Vector2 player_position = world.registry.get<Position_C>(world.player);
+        std::printf(
+            "ticks: %u\nseconds: %.6f\nticks_per_second: %.1f\nplayer: %.6f %.6f\n",
+            n_ticks,
+            seconds,
+            seconds > 0.0 ? n_ticks / seconds : 0.0,
+            player_position.x,
+            player_position.y
+        );
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
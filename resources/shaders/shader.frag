@@ -10,10 +10,22 @@ uniform sampler2D texture0;
 vec4 texture2DAA(sampler2D tex, vec2 uv) {
     vec2 texsize = vec2(textureSize(tex,0));
     vec2 uv_texspace = uv*texsize;
+    vec2 duv_dx = dFdx(uv);
+    vec2 duv_dy = dFdy(uv);
+
+    // Minified: plain mipmapped sampling, the seams are below a pixel
+    vec2 texels_per_pixel = fwidth(uv_texspace);
+    if (max(texels_per_pixel.x, texels_per_pixel.y) >= 1.0) {
+        return textureGrad(tex, uv, duv_dx, duv_dy);
+    }
+
     vec2 seam = floor(uv_texspace+.5);
-    uv_texspace = (uv_texspace-seam)/fwidth(uv_texspace)+seam;
+    uv_texspace = (uv_texspace-seam)/texels_per_pixel+seam;
     uv_texspace = clamp(uv_texspace, seam-.5, seam+.5);
-    return texture(tex, uv_texspace/texsize);
+
+    // The gradients of the unwarped uv pick the mip level, the warped ones
+    // jump at the seams
+    return textureGrad(tex, uv_texspace/texsize, duv_dx, duv_dy);
 }
 
 void main() {
@@ -0,0 +1,84 @@
+#include "animation.hpp"
+
+#include "json.hpp"
+#include "json_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+AnimationTable::AnimationTable() = default;
+
+AnimationTable::AnimationTable(std::string ase_json_file_path) {
+    json ase = load_json(ase_json_file_path);
+
+    std::vector<float> durations;
+    for (auto frame : ase["frames"]) {
+        durations.push_back(frame["duration"].get<float>() / 1000.0f);
+    }
+
+    for (auto tag : ase["meta"].value("frameTags", json::array())) {
+        uint32_t from = tag["from"];
+        uint32_t to = tag["to"];
+        std::string direction = tag.value("direction", "forward");
+        if (from > to || to >= durations.size()) {
+            throw std::runtime_error(
+                "Invalid frame range of the animation tag: "
+                + tag["name"].get<std::string>()
+            );
+        }
+
+        std::vector<uint32_t> frames;
+        for (uint32_t idx = from; idx <= to; ++idx) frames.push_back(idx);
+        if (direction == "reverse" || direction == "pingpong_reverse") {
+            std::reverse(frames.begin(), frames.end());
+        }
+        if (direction == "pingpong" || direction == "pingpong_reverse") {
+            for (int i = (int)frames.size() - 2; i > 0; --i) {
+                frames.push_back(frames[i]);
+            }
+        }
+
+        AnimationClip clip = {
+            .first = (uint32_t)this->frame_idxs.size(),
+            .n_frames = (uint32_t)frames.size(),
+            .duration = 0.0,
+            .n_repeats = (uint32_t)std::stoul(tag.value("repeat", "0"))};
+        for (uint32_t frame_idx : frames) {
+            clip.duration += durations[frame_idx];
+            this->frame_idxs.push_back(frame_idx);
+            this->frame_end_times.push_back(clip.duration);
+        }
+
+        this->clip_idxs[tag["name"]] = this->clips.size();
+        this->clips.push_back(clip);
+    }
+}
+
+uint32_t AnimationTable::get_clip_idx(std::string name) {
+    auto it = this->clip_idxs.find(name);
+    if (it == this->clip_idxs.end()) {
+        throw std::runtime_error("Failed to find the animation clip: " + name);
+    }
+
+    return it->second;
+}
+
+uint32_t AnimationTable::get_frame_idx(uint32_t clip_idx, float time) {
+    const AnimationClip &clip = this->clips[clip_idx];
+    const float *end_times = &this->frame_end_times[clip.first];
+    const uint32_t *frames = &this->frame_idxs[clip.first];
+
+    if (clip.duration <= 0.0) return frames[0];
+    if (clip.n_repeats > 0 && time >= clip.duration * clip.n_repeats) {
+        return frames[clip.n_frames - 1];
+    }
+
+    time = std::fmod(std::max(time, 0.0f), clip.duration);
+    uint32_t i = 0;
+    while (i < clip.n_frames - 1 && time >= end_times[i]) ++i;
+    return frames[i];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AnimationClip {
+    // Range of the clip frames in the table's (unrolled) frame arrays
+    uint32_t first;
+    uint32_t n_frames;
+
+    // Duration of one cycle, seconds
+    float duration;
+
+    // 0 - loop forever, otherwise hold the last frame after n cycles
+    uint32_t n_repeats;
+};
+
+// Clip table built from the Aseprite frame tags and per-frame durations.
+// Frames of all clips are stored unrolled (reverse and ping-pong directions
+// are expanded on load) in two flat arrays, so the frame lookup is a plain
+// scan over a few contiguous floats.
+class AnimationTable {
+private:
+    std::vector<AnimationClip> clips;
+    std::unordered_map<std::string, uint32_t> clip_idxs;
+
+    std::vector<uint32_t> frame_idxs;
+    std::vector<float> frame_end_times;
+
+public:
+    AnimationTable();
+    AnimationTable(std::string ase_json_file_path);
+
+    uint32_t get_clip_idx(std::string name);
+    uint32_t get_frame_idx(uint32_t clip_idx, float time);
+};
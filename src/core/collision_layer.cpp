@@ -0,0 +1,128 @@
+#include "collision_layer.hpp"
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+CollisionLayer::CollisionLayer(
+    uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size, Vector2 origin
+)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , chunk_size(chunk_size)
+    , n_chunk_rows((n_rows + chunk_size - 1) / chunk_size)
+    , n_chunk_cols((n_cols + chunk_size - 1) / chunk_size)
+    , origin(origin)
+    , solids(n_rows, n_cols)
+    , chunk_rects(n_chunk_rows * n_chunk_cols)
+    , is_chunk_dirty(n_chunk_rows * n_chunk_cols, 0)
+    , is_covered(chunk_size * chunk_size, 0) {}
+
+void CollisionLayer::set_solid(int32_t row, int32_t col, bool is_solid) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return;
+    if (col < 0 || col >= (int32_t)this->n_cols) return;
+    if (this->solids.get(row, col) == is_solid) return;
+
+    this->solids.set(row, col, is_solid);
+
+    uint32_t chunk_idx = row / this->chunk_size * this->n_chunk_cols
+                         + col / this->chunk_size;
+    if (this->is_chunk_dirty[chunk_idx]) return;
+    this->is_chunk_dirty[chunk_idx] = 1;
+    this->dirty_chunk_idxs.push_back(chunk_idx);
+}
+
+void CollisionLayer::build_chunk(uint32_t chunk_idx) {
+    std::vector<Rectangle> &rects = this->chunk_rects[chunk_idx];
+    rects.clear();
+
+    uint32_t size = this->chunk_size;
+    int32_t row0 = chunk_idx / this->n_chunk_cols * size;
+    int32_t col0 = chunk_idx % this->n_chunk_cols * size;
+    int32_t n_rows = std::min(size, this->n_rows - row0);
+    int32_t n_cols = std::min(size, this->n_cols - col0);
+    std::fill(this->is_covered.begin(), this->is_covered.end(), 0);
+
+    auto is_free = [&](int32_t row, int32_t col) {
+        return this->solids.get(row0 + row, col0 + col)
+               && !this->is_covered[row * size + col];
+    };
+
+    // Greedy meshing: grow each rect from its top left cell as wide as
+    // possible, then down while the whole span below is still solid
+    for (int32_t row = 0; row < n_rows; ++row) {
+        for (int32_t col = 0; col < n_cols; ++col) {
+            if (!is_free(row, col)) continue;
+
+            int32_t width = 1;
+            while (col + width < n_cols && is_free(row, col + width)) ++width;
+
+            int32_t height = 1;
+            while (row + height < n_rows) {
+                bool is_span_free = true;
+                for (int32_t i = 0; i < width && is_span_free; ++i) {
+                    is_span_free = is_free(row + height, col + i);
+                }
+                if (!is_span_free) break;
+                ++height;
+            }
+
+            for (int32_t r = row; r < row + height; ++r) {
+                for (int32_t c = col; c < col + width; ++c) {
+                    this->is_covered[r * size + c] = 1;
+                }
+            }
+
+            rects.push_back(
+                {.x = this->origin.x + col0 + col,
+                 .y = this->origin.y + row0 + row,
+                 .width = (float)width,
+                 .height = (float)height}
+            );
+        }
+    }
+}
+
+void CollisionLayer::update() {
+    for (uint32_t chunk_idx : this->dirty_chunk_idxs) {
+        this->build_chunk(chunk_idx);
+        this->is_chunk_dirty[chunk_idx] = 0;
+    }
+    this->dirty_chunk_idxs.clear();
+}
+
+void CollisionLayer::query(Rectangle rect, std::vector<Rectangle> &rects) const {
+    float left = rect.x - this->origin.x;
+    float top = rect.y - this->origin.y;
+    float right = left + rect.width;
+    float bot = top + rect.height;
+    float chunk_size = this->chunk_size;
+    float n_chunk_rows = this->n_chunk_rows;
+    float n_chunk_cols = this->n_chunk_cols;
+
+    int32_t first_row = std::max(0.0f, std::floor(top / chunk_size));
+    int32_t first_col = std::max(0.0f, std::floor(left / chunk_size));
+    int32_t last_row = std::min(n_chunk_rows - 1.0f, std::floor(bot / chunk_size));
+    int32_t last_col = std::min(n_chunk_cols - 1.0f, std::floor(right / chunk_size));
+
+    for (int32_t row = first_row; row <= last_row; ++row) {
+        for (int32_t col = first_col; col <= last_col; ++col) {
+            uint32_t chunk_idx = row * this->n_chunk_cols + col;
+            for (Rectangle r : this->chunk_rects[chunk_idx]) {
+                if (r.x < rect.x + rect.width && rect.x < r.x + r.width
+                    && r.y < rect.y + rect.height && rect.y < r.y + r.height) {
+                    rects.push_back(r);
+                }
+            }
+        }
+    }
+}
+
+uint32_t CollisionLayer::get_n_rects() const {
+    uint32_t n = 0;
+    for (auto &rects : this->chunk_rects) n += rects.size();
+    return n;
+}
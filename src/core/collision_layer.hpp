@@ -0,0 +1,48 @@
+#pragma once
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+// Static collision geometry of the solid grid cells. The grid is split into
+// square chunks and the solid cells of every chunk are greedily merged into
+// a few maximal rectangles, so a body next to a long wall tests one shape
+// instead of a row of unit cells (and doesn't snag on the seams between
+// them). The rects stop at the chunk borders, get_circle_rects_mtv()
+// resolves a body against them without snagging on those seams either.
+//
+// Changing a cell marks its chunk dirty, dirty chunks are re-meshed on
+// update().
+class CollisionLayer {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t chunk_size;
+    uint32_t n_chunk_rows;
+    uint32_t n_chunk_cols;
+
+    // World position of the grid's top left corner, cells are unit squares
+    Vector2 origin;
+
+    GridMask solids;
+    std::vector<std::vector<Rectangle>> chunk_rects;
+
+    std::vector<uint32_t> dirty_chunk_idxs;
+    std::vector<uint8_t> is_chunk_dirty;
+
+    // Scratch mask of the cells already covered while meshing a chunk
+    std::vector<uint8_t> is_covered;
+
+    void build_chunk(uint32_t chunk_idx);
+
+public:
+    CollisionLayer(uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size, Vector2 origin);
+
+    void set_solid(int32_t row, int32_t col, bool is_solid);
+    void update();
+
+    // Appends the rectangles of the chunks which overlap the world space rect
+    void query(Rectangle rect, std::vector<Rectangle> &rects) const;
+    uint32_t get_n_rects() const;
+};
@@ -0,0 +1,222 @@
+#include "distance_field.hpp"
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+DistanceField::DistanceField(
+    uint32_t n_rows,
+    uint32_t n_cols,
+    uint32_t chunk_size,
+    float max_dist,
+    Vector2 origin
+)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , chunk_size(chunk_size)
+    , n_chunk_rows((n_rows + chunk_size - 1) / chunk_size)
+    , n_chunk_cols((n_cols + chunk_size - 1) / chunk_size)
+    , max_dist(max_dist)
+    , margin((int32_t)std::ceil(max_dist) + 1)
+    , origin(origin)
+    , solids(n_rows, n_cols)
+    , dists(n_rows * n_cols, max_dist)
+    , is_chunk_dirty(n_chunk_rows * n_chunk_cols, 0) {
+
+    uint32_t window_size = chunk_size + 2 * this->margin;
+    this->to_solid.resize(window_size * window_size);
+    this->to_free.resize(window_size * window_size);
+    this->line_in.resize(window_size);
+    this->line_out.resize(window_size);
+    this->parabola_idxs.resize(window_size);
+    this->parabola_bounds.resize(window_size + 1);
+}
+
+void DistanceField::mark_chunk(int32_t chunk_row, int32_t chunk_col) {
+    if (chunk_row < 0 || chunk_row >= (int32_t)this->n_chunk_rows) return;
+    if (chunk_col < 0 || chunk_col >= (int32_t)this->n_chunk_cols) return;
+
+    uint32_t chunk_idx = chunk_row * this->n_chunk_cols + chunk_col;
+    if (this->is_chunk_dirty[chunk_idx]) return;
+    this->is_chunk_dirty[chunk_idx] = 1;
+    this->dirty_chunk_idxs.push_back(chunk_idx);
+}
+
+void DistanceField::set_solid(int32_t row, int32_t col, bool is_solid) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return;
+    if (col < 0 || col >= (int32_t)this->n_cols) return;
+    if (this->solids.get(row, col) == is_solid) return;
+
+    this->solids.set(row, col, is_solid);
+
+    int32_t size = this->chunk_size;
+    int32_t first_row = std::max(0, row - this->margin) / size;
+    int32_t first_col = std::max(0, col - this->margin) / size;
+    int32_t last_row = (row + this->margin) / size;
+    int32_t last_col = (col + this->margin) / size;
+    for (int32_t chunk_row = first_row; chunk_row <= last_row; ++chunk_row) {
+        for (int32_t chunk_col = first_col; chunk_col <= last_col; ++chunk_col) {
+            this->mark_chunk(chunk_row, chunk_col);
+        }
+    }
+}
+
+void DistanceField::transform_line(uint32_t n) {
+    // Lower envelope of the parabolas (q - i)^2 + f(i) rooted at the finite
+    // samples (Felzenszwalb & Huttenlocher), then read off left to right
+    const std::vector<float> &f = this->line_in;
+    std::vector<int32_t> &v = this->parabola_idxs;
+    std::vector<float> &z = this->parabola_bounds;
+
+    int32_t k = -1;
+    for (int32_t q = 0; q < (int32_t)n; ++q) {
+        if (std::isinf(f[q])) continue;
+        if (k < 0) {
+            k = 0;
+            v[0] = q;
+            z[0] = -INFINITY;
+            z[1] = INFINITY;
+            continue;
+        }
+
+        float s;
+        while (true) {
+            int32_t p = v[k];
+            s = ((f[q] + q * q) - (f[p] + p * p)) / (2.0f * (q - p));
+            if (s > z[k]) break;
+            k -= 1;
+        }
+        k += 1;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INFINITY;
+    }
+
+    if (k < 0) {
+        std::fill(this->line_out.begin(), this->line_out.begin() + n, INFINITY);
+        return;
+    }
+
+    k = 0;
+    for (int32_t q = 0; q < (int32_t)n; ++q) {
+        while (z[k + 1] < q) k += 1;
+        float d = q - v[k];
+        this->line_out[q] = d * d + f[v[k]];
+    }
+}
+
+void DistanceField::transform(
+    std::vector<float> &grid, uint32_t n_rows, uint32_t n_cols
+) {
+    for (uint32_t col = 0; col < n_cols; ++col) {
+        for (uint32_t row = 0; row < n_rows; ++row) {
+            this->line_in[row] = grid[row * n_cols + col];
+        }
+        this->transform_line(n_rows);
+        for (uint32_t row = 0; row < n_rows; ++row) {
+            grid[row * n_cols + col] = this->line_out[row];
+        }
+    }
+
+    for (uint32_t row = 0; row < n_rows; ++row) {
+        std::copy_n(&grid[row * n_cols], n_cols, this->line_in.begin());
+        this->transform_line(n_cols);
+        std::copy_n(this->line_out.begin(), n_cols, &grid[row * n_cols]);
+    }
+}
+
+void DistanceField::build_chunk(uint32_t chunk_idx) {
+    int32_t size = this->chunk_size;
+    int32_t chunk_row0 = chunk_idx / this->n_chunk_cols * size;
+    int32_t chunk_col0 = chunk_idx % this->n_chunk_cols * size;
+    int32_t chunk_n_rows = std::min(size, (int32_t)this->n_rows - chunk_row0);
+    int32_t chunk_n_cols = std::min(size, (int32_t)this->n_cols - chunk_col0);
+
+    // Solids farther than the margin are beyond max_dist anyway
+    int32_t row0 = std::max(0, chunk_row0 - this->margin);
+    int32_t col0 = std::max(0, chunk_col0 - this->margin);
+    int32_t row1 = std::min((int32_t)this->n_rows, chunk_row0 + size + this->margin);
+    int32_t col1 = std::min((int32_t)this->n_cols, chunk_col0 + size + this->margin);
+    uint32_t n_rows = row1 - row0;
+    uint32_t n_cols = col1 - col0;
+
+    uint32_t n_solids = 0;
+    for (uint32_t row = 0; row < n_rows; ++row) {
+        for (uint32_t col = 0; col < n_cols; ++col) {
+            bool is_solid = this->solids.get(row0 + row, col0 + col);
+            this->to_solid[row * n_cols + col] = is_solid ? 0.0f : INFINITY;
+            this->to_free[row * n_cols + col] = is_solid ? INFINITY : 0.0f;
+            n_solids += is_solid;
+        }
+    }
+
+    // Open areas (the common case) need no transform
+    if (n_solids == 0) {
+        for (int32_t row = 0; row < chunk_n_rows; ++row) {
+            float *dists = &this->dists[(chunk_row0 + row) * this->n_cols + chunk_col0];
+            std::fill(dists, dists + chunk_n_cols, this->max_dist);
+        }
+        return;
+    }
+
+    this->transform(this->to_solid, n_rows, n_cols);
+    this->transform(this->to_free, n_rows, n_cols);
+
+    // Squared center-to-center distances, the edge is half a cell closer
+    for (int32_t row = 0; row < chunk_n_rows; ++row) {
+        for (int32_t col = 0; col < chunk_n_cols; ++col) {
+            uint32_t window_idx = (chunk_row0 - row0 + row) * n_cols
+                                  + (chunk_col0 - col0 + col);
+            float dist = std::sqrt(this->to_solid[window_idx]) - 0.5f;
+            if (dist < 0.0f) dist = 0.5f - std::sqrt(this->to_free[window_idx]);
+
+            uint32_t idx = (chunk_row0 + row) * this->n_cols + chunk_col0 + col;
+            this->dists[idx] = std::clamp(dist, -this->max_dist, this->max_dist);
+        }
+    }
+}
+
+void DistanceField::update() {
+    for (uint32_t chunk_idx : this->dirty_chunk_idxs) {
+        this->build_chunk(chunk_idx);
+        this->is_chunk_dirty[chunk_idx] = 0;
+    }
+    this->dirty_chunk_idxs.clear();
+}
+
+float DistanceField::get_cell_dist(int32_t row, int32_t col) const {
+    row = std::clamp(row, 0, (int32_t)this->n_rows - 1);
+    col = std::clamp(col, 0, (int32_t)this->n_cols - 1);
+    return this->dists[row * this->n_cols + col];
+}
+
+float DistanceField::get_distance(Vector2 position) const {
+    // Relative to the top left cell's center
+    float x = position.x - this->origin.x - 0.5f;
+    float y = position.y - this->origin.y - 0.5f;
+    int32_t col = std::floor(x);
+    int32_t row = std::floor(y);
+    float tx = x - col;
+    float ty = y - row;
+
+    float d00 = this->get_cell_dist(row, col);
+    float d01 = this->get_cell_dist(row, col + 1);
+    float d10 = this->get_cell_dist(row + 1, col);
+    float d11 = this->get_cell_dist(row + 1, col + 1);
+    float top = d00 + (d01 - d00) * tx;
+    float bot = d10 + (d11 - d10) * tx;
+    return top + (bot - top) * ty;
+}
+
+Vector2 DistanceField::get_gradient(Vector2 position) const {
+    static const float h = 0.5;
+
+    float dx = this->get_distance({position.x + h, position.y})
+               - this->get_distance({position.x - h, position.y});
+    float dy = this->get_distance({position.x, position.y + h})
+               - this->get_distance({position.x, position.y - h});
+    return {dx / (2.0f * h), dy / (2.0f * h)};
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+// Signed distance from the cell centers to the nearest solid cell's edge:
+// positive outside the solids, negative inside, clamped to +-max_dist.
+// Computed with the two-pass (columns, then rows) exact Euclidean distance
+// transform, so a lookup is a bilinear sample of the four nearest cells.
+//
+// Changing a cell dirties every chunk within max_dist of it, those are
+// recomputed on update() from a window of the chunk and a max_dist margin.
+class DistanceField {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t chunk_size;
+    uint32_t n_chunk_rows;
+    uint32_t n_chunk_cols;
+    float max_dist;
+
+    // Cells around a chunk whose solids can still change its distances
+    int32_t margin;
+
+    // World position of the grid's top left corner, cells are unit squares
+    Vector2 origin;
+
+    GridMask solids;
+    std::vector<float> dists;
+
+    std::vector<uint32_t> dirty_chunk_idxs;
+    std::vector<uint8_t> is_chunk_dirty;
+
+    // Scratch buffers of the window transform
+    std::vector<float> to_solid;
+    std::vector<float> to_free;
+    std::vector<float> line_in;
+    std::vector<float> line_out;
+    std::vector<int32_t> parabola_idxs;
+    std::vector<float> parabola_bounds;
+
+    void mark_chunk(int32_t chunk_row, int32_t chunk_col);
+    void transform_line(uint32_t n);
+    void transform(std::vector<float> &grid, uint32_t n_rows, uint32_t n_cols);
+    void build_chunk(uint32_t chunk_idx);
+    float get_cell_dist(int32_t row, int32_t col) const;
+
+public:
+    DistanceField(
+        uint32_t n_rows,
+        uint32_t n_cols,
+        uint32_t chunk_size,
+        float max_dist,
+        Vector2 origin
+    );
+
+    void set_solid(int32_t row, int32_t col, bool is_solid);
+
+    // Recomputes the dirty chunks
+    void update();
+
+    // Bilinear sample at the world position
+    float get_distance(Vector2 position) const;
+
+    // Direction of the fastest distance increase (away from the solids),
+    // about unit length near them and zero beyond max_dist
+    Vector2 get_gradient(Vector2 position) const;
+};
@@ -0,0 +1,151 @@
+#include "edit_journal.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+static void write_varint(std::vector<uint8_t> &data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    data.push_back(value);
+}
+
+static uint32_t read_varint(const std::vector<uint8_t> &data, uint32_t *pos) {
+    uint32_t value = 0;
+    for (uint32_t shift = 0;; shift += 7) {
+        uint8_t byte = data[(*pos)++];
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+EditJournal::EditJournal(uint32_t max_n_bytes)
+    : max_n_bytes(max_n_bytes) {}
+
+void EditJournal::record(uint32_t idx, uint32_t old_value, uint32_t new_value) {
+    this->pending_edits.push_back(
+        {.idx = idx, .old_value = old_value, .new_value = new_value}
+    );
+}
+
+bool EditJournal::commit() {
+    std::vector<Edit> &edits = this->pending_edits;
+    if (edits.empty()) return false;
+
+    // -------------------------------------------------------------------
+    // Collapse repeated edits of a cell: the first old and the last new
+    // value count. The sort is stable, so the edits keep their order
+    std::stable_sort(edits.begin(), edits.end(), [](const Edit &lhs, const Edit &rhs) {
+        return lhs.idx < rhs.idx;
+    });
+
+    uint32_t n_edits = 0;
+    for (uint32_t i = 0; i < edits.size(); ++i) {
+        if (n_edits > 0 && edits[n_edits - 1].idx == edits[i].idx) {
+            edits[n_edits - 1].new_value = edits[i].new_value;
+        } else {
+            edits[n_edits++] = edits[i];
+        }
+    }
+    edits.resize(n_edits);
+    std::erase_if(edits, [](const Edit &edit) {
+        return edit.old_value == edit.new_value;
+    });
+    if (edits.empty()) return false;
+
+    // -------------------------------------------------------------------
+    // Runs of consecutive cells with the same change
+    std::vector<uint8_t> action;
+    uint32_t prev_idx = 0;
+    for (uint32_t i = 0; i < edits.size();) {
+        uint32_t n = 1;
+        while (i + n < edits.size() && edits[i + n].idx == edits[i].idx + n
+               && edits[i + n].old_value == edits[i].old_value
+               && edits[i + n].new_value == edits[i].new_value) {
+            ++n;
+        }
+
+        write_varint(action, edits[i].idx - prev_idx);
+        write_varint(action, n);
+        write_varint(action, edits[i].old_value);
+        write_varint(action, edits[i].new_value);
+        prev_idx = edits[i].idx + n;
+        i += n;
+    }
+    edits.clear();
+
+    // -------------------------------------------------------------------
+    // Drop the redo history, then the oldest actions over the budget
+    while (this->actions.size() > this->cursor) {
+        this->n_bytes -= this->actions.back().size();
+        this->actions.pop_back();
+    }
+
+    this->n_bytes += action.size();
+    this->actions.push_back(std::move(action));
+    this->cursor += 1;
+    while (this->n_bytes > this->max_n_bytes && this->actions.size() > 1) {
+        this->n_bytes -= this->actions.front().size();
+        this->actions.pop_front();
+        this->cursor -= 1;
+    }
+
+    return true;
+}
+
+void EditJournal::decode(
+    const std::vector<uint8_t> &action, std::vector<Edit> &edits
+) const {
+    edits.clear();
+    uint32_t pos = 0;
+    uint32_t idx = 0;
+    while (pos < action.size()) {
+        idx += read_varint(action, &pos);
+        uint32_t n = read_varint(action, &pos);
+        uint32_t old_value = read_varint(action, &pos);
+        uint32_t new_value = read_varint(action, &pos);
+        for (uint32_t i = 0; i < n; ++i) {
+            edits.push_back(
+                {.idx = idx++, .old_value = old_value, .new_value = new_value}
+            );
+        }
+    }
+}
+
+bool EditJournal::undo(std::vector<Edit> &edits) {
+    this->commit();
+    if (this->cursor == 0) return false;
+
+    this->cursor -= 1;
+    this->decode(this->actions[this->cursor], edits);
+    for (Edit &edit : edits) std::swap(edit.old_value, edit.new_value);
+    return true;
+}
+
+bool EditJournal::redo(std::vector<Edit> &edits) {
+    this->commit();
+    if (this->cursor == this->actions.size()) return false;
+
+    this->decode(this->actions[this->cursor], edits);
+    this->cursor += 1;
+    return true;
+}
+
+void EditJournal::clear() {
+    this->pending_edits.clear();
+    this->actions.clear();
+    this->n_bytes = 0;
+    this->cursor = 0;
+}
+
+uint32_t EditJournal::get_n_bytes() const {
+    return this->n_bytes;
+}
+
+uint32_t EditJournal::get_n_actions() const {
+    return this->actions.size();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Undo/redo log of grid edits. Edits are collected until commit(), which
+// turns them into one action: the changed cells sorted by index and stored
+// as runs (index gap, run length, old and new value as varints), so strokes
+// and filled rects take a few bytes per row.
+//
+// The oldest actions are dropped once the log exceeds its byte budget.
+class EditJournal {
+public:
+    struct Edit {
+        uint32_t idx;
+        uint32_t old_value;
+        uint32_t new_value;
+    };
+
+private:
+    uint32_t max_n_bytes;
+    uint32_t n_bytes = 0;
+
+    std::vector<Edit> pending_edits;
+
+    // Actions up to the cursor are applied, the rest can be redone
+    std::deque<std::vector<uint8_t>> actions;
+    uint32_t cursor = 0;
+
+    void decode(const std::vector<uint8_t> &action, std::vector<Edit> &edits) const;
+
+public:
+    explicit EditJournal(uint32_t max_n_bytes);
+
+    void record(uint32_t idx, uint32_t old_value, uint32_t new_value);
+
+    // Encodes the pending edits as one action and drops the redo history,
+    // no-op if nothing changed. Returns whether an action was added
+    bool commit();
+
+    // Fill the edits to apply (every cell gets its new_value) and move the
+    // cursor, false if there is nothing to undo (redo). Pending edits are
+    // committed first
+    bool undo(std::vector<Edit> &edits);
+    bool redo(std::vector<Edit> &edits);
+
+    // Forgets the history and the pending edits
+    void clear();
+
+    uint32_t get_n_bytes() const;
+    uint32_t get_n_actions() const;
+};
@@ -0,0 +1,301 @@
+#include "flow_field.hpp"
+
+#include "raylib.h"
+#include "terrain.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <utility>
+#include <vector>
+
+// Neighbor order matches CellNeighbors: left, then clockwise. Even
+// directions are orthogonal, odd ones are diagonal
+static const int32_t dir_rows[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+static const int32_t dir_cols[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+static const float dir_lens[8] = {
+    1.0, M_SQRT2, 1.0, M_SQRT2, 1.0, M_SQRT2, 1.0, M_SQRT2};
+static const Vector2 dir_vecs[9] = {
+    {-1.0, 0.0},
+    {-M_SQRT1_2, -M_SQRT1_2},
+    {0.0, -1.0},
+    {M_SQRT1_2, -M_SQRT1_2},
+    {1.0, 0.0},
+    {M_SQRT1_2, M_SQRT1_2},
+    {0.0, 1.0},
+    {-M_SQRT1_2, M_SQRT1_2},
+    {0.0, 0.0},
+};
+static constexpr uint8_t no_dir = 8;
+
+using HeapItem = std::pair<float, uint32_t>;
+
+// -----------------------------------------------------------------------
+// flow field
+FlowField::FlowField(uint32_t n_rows, uint32_t n_cols, uint32_t goal_idx, float door_cost)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , goal_idx(goal_idx)
+    , door_cost(door_cost) {}
+
+uint32_t FlowField::get_goal_idx() const {
+    return this->goal_idx;
+}
+
+float FlowField::get_door_cost() const {
+    return this->door_cost;
+}
+
+float FlowField::get_cost(Terrain terrain) {
+    switch (terrain) {
+        case Terrain::FLOOR: return 1.0;
+        case Terrain::DOOR: return this->door_cost < 0.0 ? INFINITY : this->door_cost;
+        case Terrain::WALL: return INFINITY;
+    }
+    return INFINITY;
+}
+
+bool FlowField::get_neighbor(uint32_t idx, uint32_t dir, uint32_t *nb_idx) {
+    int32_t row = idx / this->n_cols + dir_rows[dir];
+    int32_t col = idx % this->n_cols + dir_cols[dir];
+    if (row < 0 || row >= (int32_t)this->n_rows) return false;
+    if (col < 0 || col >= (int32_t)this->n_cols) return false;
+
+    *nb_idx = row * this->n_cols + col;
+    return true;
+}
+
+bool FlowField::can_step(
+    const std::vector<Terrain> &terrain, uint32_t idx, uint32_t dir
+) {
+    uint32_t nb_idx;
+    if (!this->get_neighbor(idx, dir, &nb_idx)) return false;
+    if (std::isinf(this->get_cost(terrain[nb_idx]))) return false;
+    if (dir % 2 == 0) return true;
+
+    // Diagonal step: both orthogonal cells must be passable
+    uint32_t a, b;
+    this->get_neighbor(idx, dir - 1, &a);
+    this->get_neighbor(idx, (dir + 1) % 8, &b);
+    return !std::isinf(this->get_cost(terrain[a]))
+           && !std::isinf(this->get_cost(terrain[b]));
+}
+
+void FlowField::propagate(
+    const std::vector<Terrain> &terrain,
+    std::vector<HeapItem> &heap,
+    std::vector<uint32_t> &touched_idxs
+) {
+    auto cmp = std::greater<HeapItem>();
+    std::make_heap(heap.begin(), heap.end(), cmp);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto [dist, idx] = heap.back();
+        heap.pop_back();
+        if (dist > this->dists[idx]) continue;
+
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb_idx;
+            if (!this->can_step(terrain, idx, dir)) continue;
+            this->get_neighbor(idx, dir, &nb_idx);
+
+            float nb_dist = dist + this->get_cost(terrain[nb_idx]) * dir_lens[dir];
+            if (nb_dist < this->dists[nb_idx]) {
+                this->dists[nb_idx] = nb_dist;
+                touched_idxs.push_back(nb_idx);
+                heap.push_back({nb_dist, nb_idx});
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+        }
+    }
+}
+
+void FlowField::update_dir(const std::vector<Terrain> &terrain, uint32_t idx) {
+    // The next step is the neighbor the cell's distance was integrated
+    // from, so following the dirs gives the shortest path tree
+    this->dirs[idx] = no_dir;
+    if (idx == this->goal_idx || std::isinf(this->dists[idx])) return;
+
+    float cost = this->get_cost(terrain[idx]);
+    float best_dist = INFINITY;
+    for (uint32_t dir = 0; dir < 8; ++dir) {
+        uint32_t nb_idx;
+        if (!this->can_step(terrain, idx, dir)) continue;
+        this->get_neighbor(idx, dir, &nb_idx);
+
+        float dist = this->dists[nb_idx] + cost * dir_lens[dir];
+        if (dist < best_dist) {
+            best_dist = dist;
+            this->dirs[idx] = dir;
+        }
+    }
+}
+
+void FlowField::compute(const std::vector<Terrain> &terrain) {
+    uint32_t n_cells = this->n_rows * this->n_cols;
+    this->dists.assign(n_cells, INFINITY);
+    this->dirs.assign(n_cells, no_dir);
+    this->stamps.assign(n_cells, 0);
+    this->stamp = 0;
+
+    std::vector<HeapItem> heap;
+    std::vector<uint32_t> touched_idxs;
+    if (this->goal_idx < n_cells && !std::isinf(this->get_cost(terrain[goal_idx]))) {
+        this->dists[this->goal_idx] = 0.0;
+        heap.push_back({0.0, this->goal_idx});
+    }
+    this->propagate(terrain, heap, touched_idxs);
+
+    for (uint32_t idx = 0; idx < n_cells; ++idx) this->update_dir(terrain, idx);
+}
+
+void FlowField::repair(
+    const std::vector<Terrain> &terrain, const std::vector<uint32_t> &changed_idxs
+) {
+    if (this->dists.empty()) {
+        this->compute(terrain);
+        return;
+    }
+
+    this->stamp += 1;
+    std::vector<uint32_t> invalid_idxs;
+    auto invalidate = [&](uint32_t idx) {
+        if (this->stamps[idx] == this->stamp) return;
+        this->stamps[idx] = this->stamp;
+        invalid_idxs.push_back(idx);
+    };
+
+    // -------------------------------------------------------------------
+    // Invalidate the subtrees which hang on the changed cells: the changed
+    // cells themselves and the neighbors whose next step became illegal
+    // (e.g. a diagonal step cutting a new wall corner)
+    for (uint32_t idx : changed_idxs) {
+        invalidate(idx);
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb_idx;
+            if (!this->get_neighbor(idx, dir, &nb_idx)) continue;
+            uint8_t nb_dir = this->dirs[nb_idx];
+            if (nb_dir != no_dir && !this->can_step(terrain, nb_idx, nb_dir)) {
+                invalidate(nb_idx);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < invalid_idxs.size(); ++i) {
+        uint32_t parent_idx = invalid_idxs[i];
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb_idx;
+            if (!this->get_neighbor(parent_idx, dir, &nb_idx)) continue;
+
+            // Neighbor is a child if its step goes back along this dir
+            if (this->dirs[nb_idx] == (dir + 4) % 8) invalidate(nb_idx);
+        }
+    }
+
+    for (uint32_t idx : invalid_idxs) {
+        this->dists[idx] = INFINITY;
+        this->dirs[idx] = no_dir;
+    }
+
+    // -------------------------------------------------------------------
+    // Re-integrate: the valid cells around the invalidated region and the
+    // changed cells are the wavefront sources
+    std::vector<HeapItem> heap;
+    std::vector<uint32_t> touched_idxs;
+    auto push_source = [&](uint32_t idx) {
+        if (!std::isinf(this->dists[idx])) heap.push_back({this->dists[idx], idx});
+    };
+
+    if (this->goal_idx < this->stamps.size()
+        && this->stamps[this->goal_idx] == this->stamp
+        && !std::isinf(this->get_cost(terrain[this->goal_idx]))) {
+        this->dists[this->goal_idx] = 0.0;
+        touched_idxs.push_back(this->goal_idx);
+    }
+
+    for (uint32_t idx : invalid_idxs) {
+        push_source(idx);
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb_idx;
+            if (this->get_neighbor(idx, dir, &nb_idx)) push_source(nb_idx);
+        }
+    }
+    this->propagate(terrain, heap, touched_idxs);
+
+    // -------------------------------------------------------------------
+    // Directions of every re-integrated cell and of their neighbors
+    for (uint32_t idx : touched_idxs) invalidate(idx);
+    uint32_t n_dirty = invalid_idxs.size();
+    for (uint32_t i = 0; i < n_dirty; ++i) {
+        uint32_t idx = invalid_idxs[i];
+        this->update_dir(terrain, idx);
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb_idx;
+            if (this->get_neighbor(idx, dir, &nb_idx)) this->update_dir(terrain, nb_idx);
+        }
+    }
+}
+
+Vector2 FlowField::get_direction(uint32_t idx) const {
+    if (idx >= this->dirs.size()) return dir_vecs[no_dir];
+    return dir_vecs[this->dirs[idx]];
+}
+
+float FlowField::get_distance(uint32_t idx) const {
+    if (idx >= this->dists.size()) return INFINITY;
+    return this->dists[idx];
+}
+
+// -----------------------------------------------------------------------
+// flow field cache
+FlowFieldCache::FlowFieldCache(uint32_t n_rows, uint32_t n_cols, uint32_t max_n_fields)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , max_n_fields(max_n_fields)
+    , terrain(n_rows * n_cols, Terrain::FLOOR) {}
+
+void FlowFieldCache::set_terrain(uint32_t idx, Terrain terrain) {
+    if (idx >= this->terrain.size() || this->terrain[idx] == terrain) return;
+
+    this->terrain[idx] = terrain;
+    this->changed_idxs.push_back(idx);
+}
+
+void FlowFieldCache::update() {
+    if (this->changed_idxs.empty()) return;
+
+    for (FlowField &field : this->fields) {
+        field.repair(this->terrain, this->changed_idxs);
+    }
+    this->changed_idxs.clear();
+}
+
+FlowField *FlowFieldCache::get_field(uint32_t goal_idx, float door_cost) {
+    for (auto it = this->fields.begin(); it != this->fields.end(); ++it) {
+        if (it->get_goal_idx() == goal_idx && it->get_door_cost() == door_cost) {
+            this->fields.splice(this->fields.begin(), this->fields, it);
+            return &this->fields.front();
+        }
+    }
+
+    if (this->fields.size() >= this->max_n_fields) this->fields.pop_back();
+
+    // New fields are computed on the current terrain, pending changes are
+    // already part of it
+    this->update();
+    this->fields.emplace_front(this->n_rows, this->n_cols, goal_idx, door_cost);
+    this->fields.front().compute(this->terrain);
+    return &this->fields.front();
+}
+
+const FlowField *FlowFieldCache::find_field(uint32_t goal_idx, float door_cost) const {
+    for (const FlowField &field : this->fields) {
+        if (field.get_goal_idx() == goal_idx && field.get_door_cost() == door_cost) {
+            return &field;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "raylib.h"
+#include "terrain.hpp"
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+// Integration field towards a single goal cell over an 8-connected grid
+// (diagonal steps can't cut wall corners). Each cell stores its path cost
+// to the goal and the direction of the next step, so sampling is O(1).
+//
+// Cells are addressed by the row-major index row * n_cols + col.
+class FlowField {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t goal_idx;
+
+    // Cost of entering a door cell, negative - doors are impassable
+    float door_cost;
+
+    std::vector<float> dists;
+    std::vector<uint8_t> dirs;
+
+    // Scratch buffers reused between repairs
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+
+    float get_cost(Terrain terrain);
+    bool get_neighbor(uint32_t idx, uint32_t dir, uint32_t *nb_idx);
+    bool can_step(const std::vector<Terrain> &terrain, uint32_t idx, uint32_t dir);
+    void propagate(
+        const std::vector<Terrain> &terrain,
+        std::vector<std::pair<float, uint32_t>> &heap,
+        std::vector<uint32_t> &touched_idxs
+    );
+    void update_dir(const std::vector<Terrain> &terrain, uint32_t idx);
+
+public:
+    FlowField(uint32_t n_rows, uint32_t n_cols, uint32_t goal_idx, float door_cost);
+
+    uint32_t get_goal_idx() const;
+    float get_door_cost() const;
+
+    void compute(const std::vector<Terrain> &terrain);
+
+    // Incrementally repairs the field after the terrain of the given cells
+    // has changed: only the cells whose paths went through them (or can
+    // now go through them) are re-integrated
+    void repair(
+        const std::vector<Terrain> &terrain, const std::vector<uint32_t> &changed_idxs
+    );
+
+    // Unit step towards the goal, zero at the goal or if it's unreachable
+    Vector2 get_direction(uint32_t idx) const;
+    float get_distance(uint32_t idx) const;
+};
+
+// Bounded cache of flow fields over a terrain snapshot. Terrain changes are
+// collected and applied to every cached field on update(), the least
+// recently requested fields are evicted first.
+class FlowFieldCache {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t max_n_fields;
+
+    std::vector<Terrain> terrain;
+    std::vector<uint32_t> changed_idxs;
+    std::list<FlowField> fields;
+
+public:
+    FlowFieldCache(uint32_t n_rows, uint32_t n_cols, uint32_t max_n_fields);
+
+    void set_terrain(uint32_t idx, Terrain terrain);
+    void update();
+
+    // Returns the cached field or computes a new one
+    FlowField *get_field(uint32_t goal_idx, float door_cost);
+
+    // Lookup only: doesn't compute or reorder, safe for concurrent readers
+    const FlowField *find_field(uint32_t goal_idx, float door_cost) const;
+};
@@ -0,0 +1,90 @@
+#include "fov.hpp"
+
+#include "grid_mask.hpp"
+#include <cstdint>
+
+// Quadrants are scanned in rows of increasing depth away from the origin,
+// the transforms map (depth, col) to the grid row and col offsets
+static const int32_t depth_rows[4] = {-1, 0, 1, 0};
+static const int32_t depth_cols[4] = {0, 1, 0, -1};
+static const int32_t col_rows[4] = {0, 1, 0, 1};
+static const int32_t col_cols[4] = {1, 0, 1, 0};
+
+static int32_t floor_div(int32_t a, int32_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+void FieldOfView::reveal(int32_t row, int32_t col) {
+    int32_t d_row = row - this->row;
+    int32_t d_col = col - this->col;
+    int32_t radius = this->radius;
+    if (d_row * d_row + d_col * d_col > radius * radius + radius) return;
+
+    this->visible.set(d_row + radius, d_col + radius, true);
+}
+
+void FieldOfView::compute(
+    const GridMask &opaque, int32_t row, int32_t col, uint32_t radius
+) {
+    uint32_t side = 2 * radius + 1;
+    if (this->visible.get_n_rows() != side) this->visible = GridMask(side, side);
+    else this->visible.clear();
+
+    this->row = row;
+    this->col = col;
+    this->radius = radius;
+
+    bool is_inside = row >= 0 && row < (int32_t)opaque.get_n_rows() && col >= 0
+                     && col < (int32_t)opaque.get_n_cols();
+    if (!is_inside) return;
+
+    this->reveal(row, col);
+    for (uint32_t quadrant = 0; quadrant < 4; ++quadrant) {
+        this->scan(opaque, quadrant, 1, {-1, 1}, {1, 1});
+    }
+}
+
+void FieldOfView::scan(
+    const GridMask &opaque, uint32_t quadrant, int32_t depth, Slope start, Slope end
+) {
+    if (depth > (int32_t)this->radius) return;
+
+    // Cells whose centers are within the slopes, ties round towards the
+    // inside of the row
+    int32_t min_col = floor_div(2 * depth * start.num + start.den, 2 * start.den);
+    int32_t max_col = -floor_div(-(2 * depth * end.num - end.den), 2 * end.den);
+
+    int32_t n_rows = opaque.get_n_rows();
+    int32_t n_cols = opaque.get_n_cols();
+
+    // -1 - no cell yet, 0 - floor, 1 - wall
+    int32_t prev = -1;
+    for (int32_t col = min_col; col <= max_col; ++col) {
+        int32_t row = this->row + depth * depth_rows[quadrant]
+                      + col * col_rows[quadrant];
+        int32_t grid_col = this->col + depth * depth_cols[quadrant]
+                           + col * col_cols[quadrant];
+
+        bool is_inside = row >= 0 && row < n_rows && grid_col >= 0 && grid_col < n_cols;
+        bool is_wall = !is_inside || opaque.get(row, grid_col);
+        bool is_symmetric = col * start.den >= depth * start.num
+                            && col * end.den <= depth * end.num;
+        if (is_inside && (is_wall || is_symmetric)) this->reveal(row, grid_col);
+
+        Slope slope = {2 * col - 1, 2 * depth};
+        if (prev == 1 && !is_wall) start = slope;
+        if (prev == 0 && is_wall) this->scan(opaque, quadrant, depth + 1, start, slope);
+        prev = is_wall;
+    }
+
+    if (prev == 0) this->scan(opaque, quadrant, depth + 1, start, end);
+}
+
+bool FieldOfView::is_visible(int32_t row, int32_t col) const {
+    int32_t radius = this->radius;
+    return this->visible.get(row - this->row + radius, col - this->col + radius);
+}
+
+uint32_t FieldOfView::get_n_visible() const {
+    return this->visible.count();
+}
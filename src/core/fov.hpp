@@ -0,0 +1,35 @@
+#pragma once
+
+#include "grid_mask.hpp"
+#include <cstdint>
+
+// Symmetric shadowcasting field of view: a cell is visible from the origin
+// if and only if the origin is visible from the cell. Opaque cells that
+// bound the view are visible themselves, the grid outside is opaque.
+//
+// The visible cells are kept in a (2 * radius + 1)^2 window mask around
+// the origin, so the cost depends on the radius only, not on the grid.
+class FieldOfView {
+private:
+    // Slope of a line through the origin as an exact fraction, den > 0
+    struct Slope {
+        int32_t num;
+        int32_t den;
+    };
+
+    int32_t row = 0;
+    int32_t col = 0;
+    uint32_t radius = 0;
+    GridMask visible;
+
+    void reveal(int32_t row, int32_t col);
+    void scan(
+        const GridMask &opaque, uint32_t quadrant, int32_t depth, Slope start, Slope end
+    );
+
+public:
+    void compute(const GridMask &opaque, int32_t row, int32_t col, uint32_t radius);
+
+    bool is_visible(int32_t row, int32_t col) const;
+    uint32_t get_n_visible() const;
+};
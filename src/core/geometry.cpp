@@ -4,6 +4,8 @@
 #include "raymath.h"
 #include <algorithm>
 #include <cfloat>
+#include <cmath>
+#include <vector>
 
 Vector2 get_orientation_vec(float orientation) {
     return {std::cos(orientation), std::sin(orientation)};
@@ -65,8 +67,8 @@ static void update_overlap(
 Vector2 get_circle_polygon_mtv(
     Vector2 position, float radius, Vector2 vertices[], int n
 ) {
-    Vector2 nearest_vertex;
-    Vector2 min_overlap_axis;
+    Vector2 nearest_vertex = {0.0, 0.0};
+    Vector2 min_overlap_axis = {0.0, 0.0};
     float nearest_dist = FLT_MAX;
     float min_overlap = FLT_MAX;
     for (int vertex_idx = 0; vertex_idx < n; ++vertex_idx) {
@@ -124,6 +126,41 @@ Vector2 get_circle_rect_mtv(Vector2 position, float radius, Rectangle rect) {
     return get_circle_polygon_mtv(position, radius, vertices, 4);
 }
 
+static Vector2 get_rect_nearest_point(Vector2 point, Rectangle rect) {
+    return {
+        std::clamp(point.x, rect.x, rect.x + rect.width),
+        std::clamp(point.y, rect.y, rect.y + rect.height)};
+}
+
+static bool is_point_on_rect(Vector2 point, Rectangle rect) {
+    return point.x >= rect.x && point.x <= rect.x + rect.width && point.y >= rect.y
+           && point.y <= rect.y + rect.height;
+}
+
+Vector2 get_circle_rects_mtv(
+    Vector2 position, float radius, const std::vector<Rectangle> &rects
+) {
+    Vector2 start = position;
+    for (size_t i = 0; i < rects.size(); ++i) {
+        Vector2 nearest = get_rect_nearest_point(position, rects[i]);
+
+        // Of two rects with the same nearest point (the body right over
+        // their seam) the first one resolves it
+        bool is_inner = false;
+        for (size_t j = 0; j < rects.size() && !is_inner; ++j) {
+            if (j == i || !is_point_on_rect(nearest, rects[j])) continue;
+            Vector2 other = get_rect_nearest_point(position, rects[j]);
+            is_inner = j < i || other.x != nearest.x || other.y != nearest.y;
+        }
+        if (is_inner) continue;
+
+        Vector2 mtv = get_circle_rect_mtv(position, radius, rects[i]);
+        position = Vector2Add(position, mtv);
+    }
+
+    return Vector2Subtract(position, start);
+}
+
 int get_line_line_intersection(
     Vector2 start0, Vector2 end0, Vector2 start1, Vector2 end1, Vector2 *intersection
 ) {
@@ -158,12 +195,15 @@ int get_line_circle_intersections(
     float cx = position.x;
     float cy = position.y;
 
+    // Relative to the center: expanding the squares loses the precision
+    // far from the world origin
     float dx = x2 - x1;
     float dy = y2 - y1;
+    float fx = x1 - cx;
+    float fy = y1 - cy;
     float a = dx * dx + dy * dy;
-    float b = 2 * (dx * (x1 - cx) + dy * (y1 - cy));
-    float c = cx * cx + cy * cy + x1 * x1 + y1 * y1 - 2 * (cx * x1 + cy * y1)
-              - radius * radius;
+    float b = 2 * (dx * fx + dy * fy);
+    float c = fx * fx + fy * fy - radius * radius;
 
     float det = b * b - 4 * a * c;
     int n_points = 0;
@@ -209,7 +249,7 @@ int get_line_polygon_intersection_nearest(
     Vector2 start, Vector2 end, Vector2 vertices[], int n, Vector2 *intersection
 ) {
     float nearest_dist = HUGE_VAL;
-    Vector2 nearest_point;
+    Vector2 nearest_point = {0.0, 0.0};
 
     for (int i = 0; i < n; ++i) {
         Vector2 s1 = vertices[i];
@@ -243,8 +283,76 @@ int get_line_rect_intersection_nearest(
     return get_line_polygon_intersection_nearest(start, end, vertices, 4, intersection);
 }
 
+bool check_point_in_rect(Vector2 point, Rectangle rect) {
+    return point.x >= rect.x && point.x < rect.x + rect.width && point.y >= rect.y
+           && point.y < rect.y + rect.height;
+}
+
+void get_visibility_polygon(
+    Vector2 origin,
+    float radius,
+    const std::vector<Segment> &segments,
+    std::vector<Vector2> &vertices
+) {
+    static const float angle_eps = 1e-4;
+    static thread_local std::vector<float> angles;
+
+    // Bounding square, so every ray hits something
+    float left = origin.x - radius;
+    float right = origin.x + radius;
+    float top = origin.y - radius;
+    float bot = origin.y + radius;
+    Segment bounds[4] = {
+        {{left, top}, {right, top}},
+        {{right, top}, {right, bot}},
+        {{right, bot}, {left, bot}},
+        {{left, bot}, {left, top}},
+    };
+
+    // Rays go to every segment end and slightly to the both sides of it,
+    // to catch the walls behind the corners
+    angles.clear();
+    auto add_angles = [&](Vector2 point) {
+        float angle = get_vec_orientation(Vector2Subtract(point, origin));
+        angles.push_back(angle - angle_eps);
+        angles.push_back(angle);
+        angles.push_back(angle + angle_eps);
+    };
+    for (Segment &segment : bounds) add_angles(segment.start);
+    for (const Segment &segment : segments) {
+        add_angles(segment.start);
+        add_angles(segment.end);
+    }
+    std::sort(angles.begin(), angles.end());
+
+    vertices.clear();
+    float ray_length = 2.0 * radius;
+    for (float angle : angles) {
+        Vector2 dir = get_orientation_vec(angle);
+        Vector2 end = Vector2Add(origin, Vector2Scale(dir, ray_length));
+        Vector2 nearest_point = end;
+        float nearest_dist = HUGE_VAL;
+
+        auto cast = [&](const Segment &segment) {
+            Vector2 point;
+            Vector2 start1 = segment.start;
+            Vector2 end1 = segment.end;
+            if (!get_line_line_intersection(origin, end, start1, end1, &point)) return;
+            float dist = Vector2DistanceSqr(origin, point);
+            if (dist < nearest_dist) {
+                nearest_point = point;
+                nearest_dist = dist;
+            }
+        };
+        for (Segment &segment : bounds) cast(segment);
+        for (const Segment &segment : segments) cast(segment);
+
+        vertices.push_back(nearest_point);
+    }
+}
+
 Rectangle get_rect_from_pivot(Vector2 position, Pivot pivot, float width, float height) {
-    Vector2 offset;
+    Vector2 offset = {0.0, 0.0};
     switch (pivot) {
         case Pivot::CENTER_BOTTOM: offset = {-0.5f * width, -height}; break;
         case Pivot::CENTER_TOP: offset = {-0.5f * width, 0.0}; break;
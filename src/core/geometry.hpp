@@ -1,6 +1,12 @@
 #pragma once
 
 #include "raylib.h"
+#include <vector>
+
+struct Segment {
+    Vector2 start;
+    Vector2 end;
+};
 
 Vector2 get_orientation_vec(float orientation);
 float get_vec_orientation(Vector2 vec);
@@ -13,6 +19,15 @@ Vector2 get_circle_circle_mtv(
     Vector2 position0, float radius0, Vector2 position1, float radius1
 );
 Vector2 get_circle_rect_mtv(Vector2 position, float radius, Rectangle rect);
+
+// Total MTV of a circle against a solid region tiled by the rects, resolved
+// one rect after another. A rect whose nearest point to the circle lies on
+// another rect too is touched on an inner edge of the region: it's skipped
+// and the other one pushes out through the real surface, so the circle
+// slides over the seams between the rects
+Vector2 get_circle_rects_mtv(
+    Vector2 position, float radius, const std::vector<Rectangle> &rects
+);
 int get_line_line_intersection(
     Vector2 start0, Vector2 end0, Vector2 start1, Vector2 end1, Vector2 *intersection
 );
@@ -29,6 +44,18 @@ int get_line_rect_intersection_nearest(
     Vector2 start, Vector2 end, Rectangle rect, Vector2 *intersection
 );
 
+// Same as raylib's CheckCollisionPointRec, without linking raylib
+bool check_point_in_rect(Vector2 point, Rectangle rect);
+
+// Angular sweep: the region visible from the origin inside the square of
+// the given half size, as a triangle fan around the origin
+void get_visibility_polygon(
+    Vector2 origin,
+    float radius,
+    const std::vector<Segment> &segments,
+    std::vector<Vector2> &vertices
+);
+
 enum class Pivot {
     CENTER_BOTTOM,
     CENTER_TOP,
@@ -0,0 +1,379 @@
+#include "geometry_batch.hpp"
+
+#include "raylib.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+
+// The AVX2 kernels are compiled with a per-function target, so the rest of
+// the build keeps the baseline instruction set and picks them at runtime
+#if defined(__GNUC__) && defined(__x86_64__)
+#define GEOMETRY_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+static constexpr uint32_t n_lanes = 8;
+
+static void check_sizes(size_t n, std::initializer_list<size_t> sizes) {
+    for (size_t size : sizes) {
+        if (size < n) throw std::runtime_error("Geometry batch span is too short");
+    }
+}
+
+bool is_geometry_batch_simd() {
+#ifdef GEOMETRY_BATCH_AVX2
+    static const bool is_avx2 = __builtin_cpu_supports("avx2");
+    return is_avx2;
+#else
+    return false;
+#endif
+}
+
+// -----------------------------------------------------------------------
+// scalar
+// Same operations in the same order as the kernels, so the tail matches
+// the lanes
+static float get_segment_circle_t(
+    float dx, float dy, float fx, float fy, float radius
+) {
+    float a = dx * dx + dy * dy;
+    float b = 2.0f * (dx * fx + dy * fy);
+    float c = fx * fx + fy * fy - radius * radius;
+    float det = b * b - 4.0f * a * c;
+    if (!(det >= 0.0f)) return INFINITY;
+
+    float root = std::sqrt(det);
+    float t1 = (-b + root) / (2.0f * a);
+    float t2 = (-b - root) / (2.0f * a);
+    float t = INFINITY;
+    if (t1 >= 0.0f && t1 <= 1.0f) t = t1;
+    if (t2 >= 0.0f && t2 <= 1.0f) t = std::min(t, t2);
+    return t;
+}
+
+// Clips the segment's parameter range to the slab lo <= s + t * d <= hi
+static void clip_slab(
+    float s, float d, float lo, float hi, float *t_enter, float *t_exit
+) {
+    if (d == 0.0f) {
+        if (s < lo || s > hi) {
+            *t_enter = INFINITY;
+            *t_exit = -INFINITY;
+        }
+        return;
+    }
+
+    float t0 = (lo - s) / d;
+    float t1 = (hi - s) / d;
+    *t_enter = std::max(*t_enter, std::min(t0, t1));
+    *t_exit = std::min(*t_exit, std::max(t0, t1));
+}
+
+// The boundary crossing: the entry, or the exit if the segment starts
+// inside the rect
+static float get_segment_rect_t(float sx, float sy, float dx, float dy, Rectangle rect) {
+    float t_enter = -INFINITY;
+    float t_exit = INFINITY;
+    clip_slab(sx, dx, rect.x, rect.x + rect.width, &t_enter, &t_exit);
+    clip_slab(sy, dy, rect.y, rect.y + rect.height, &t_enter, &t_exit);
+    if (t_enter > t_exit) return INFINITY;
+    if (t_enter >= 0.0f && t_enter <= 1.0f) return t_enter;
+    if (t_exit >= 0.0f && t_exit <= 1.0f) return t_exit;
+    return INFINITY;
+}
+
+// -----------------------------------------------------------------------
+// avx2
+#ifdef GEOMETRY_BATCH_AVX2
+__attribute__((target("avx2"))) static void store_hits(uint8_t *hits, __m256 is_hit) {
+    int mask = _mm256_movemask_ps(is_hit);
+    for (uint32_t j = 0; j < n_lanes; ++j) hits[j] = (mask >> j) & 1;
+}
+
+// Lanes within [0, 1], NaNs are not
+__attribute__((target("avx2"))) static __m256 get_is_unit(__m256 t) {
+    return _mm256_and_ps(
+        _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ),
+        _mm256_cmp_ps(t, _mm256_set1_ps(1.0f), _CMP_LE_OQ)
+    );
+}
+
+__attribute__((target("avx2"))) static uint32_t get_segments_circle_hits_avx2(
+    const SegmentBatch &segments,
+    Vector2 position,
+    float radius,
+    uint8_t *hits,
+    float *dists
+) {
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 cx = _mm256_set1_ps(position.x);
+    const __m256 cy = _mm256_set1_ps(position.y);
+    const __m256 r2 = _mm256_set1_ps(radius * radius);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+
+    uint32_t n = segments.start_xs.size() / n_lanes * n_lanes;
+    for (uint32_t i = 0; i < n; i += n_lanes) {
+        __m256 sx = _mm256_loadu_ps(&segments.start_xs[i]);
+        __m256 sy = _mm256_loadu_ps(&segments.start_ys[i]);
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&segments.end_xs[i]), sx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&segments.end_ys[i]), sy);
+        __m256 fx = _mm256_sub_ps(sx, cx);
+        __m256 fy = _mm256_sub_ps(sy, cy);
+
+        __m256 a = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 b = _mm256_mul_ps(
+            two, _mm256_add_ps(_mm256_mul_ps(dx, fx), _mm256_mul_ps(dy, fy))
+        );
+        __m256 c = _mm256_sub_ps(
+            _mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy)), r2
+        );
+        __m256 det = _mm256_sub_ps(
+            _mm256_mul_ps(b, b), _mm256_mul_ps(four, _mm256_mul_ps(a, c))
+        );
+        __m256 is_real = _mm256_cmp_ps(det, _mm256_setzero_ps(), _CMP_GE_OQ);
+
+        __m256 root = _mm256_sqrt_ps(_mm256_max_ps(det, _mm256_setzero_ps()));
+        __m256 neg_b = _mm256_sub_ps(_mm256_setzero_ps(), b);
+        __m256 two_a = _mm256_mul_ps(two, a);
+        __m256 t1 = _mm256_div_ps(_mm256_add_ps(neg_b, root), two_a);
+        __m256 t2 = _mm256_div_ps(_mm256_sub_ps(neg_b, root), two_a);
+        t1 = _mm256_blendv_ps(inf, t1, _mm256_and_ps(is_real, get_is_unit(t1)));
+        t2 = _mm256_blendv_ps(inf, t2, _mm256_and_ps(is_real, get_is_unit(t2)));
+        __m256 t = _mm256_min_ps(t1, t2);
+
+        __m256 is_hit = _mm256_cmp_ps(t, inf, _CMP_LT_OQ);
+        __m256 dist = _mm256_mul_ps(t, _mm256_sqrt_ps(a));
+        _mm256_storeu_ps(&dists[i], _mm256_blendv_ps(inf, dist, is_hit));
+        store_hits(&hits[i], is_hit);
+    }
+
+    return n;
+}
+
+// Slab of one axis, flat lanes (d == 0) are all-in or all-out
+__attribute__((target("avx2"))) static void clip_slab_avx2(
+    __m256 s, __m256 d, __m256 lo, __m256 hi, __m256 *t_enter, __m256 *t_exit
+) {
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 neg_inf = _mm256_set1_ps(-INFINITY);
+
+    __m256 t0 = _mm256_div_ps(_mm256_sub_ps(lo, s), d);
+    __m256 t1 = _mm256_div_ps(_mm256_sub_ps(hi, s), d);
+    __m256 t_min = _mm256_min_ps(t0, t1);
+    __m256 t_max = _mm256_max_ps(t0, t1);
+
+    __m256 is_flat = _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    __m256 is_out = _mm256_or_ps(
+        _mm256_cmp_ps(s, lo, _CMP_LT_OQ), _mm256_cmp_ps(s, hi, _CMP_GT_OQ)
+    );
+    t_min = _mm256_blendv_ps(t_min, _mm256_blendv_ps(neg_inf, inf, is_out), is_flat);
+    t_max = _mm256_blendv_ps(t_max, _mm256_blendv_ps(inf, neg_inf, is_out), is_flat);
+
+    *t_enter = _mm256_max_ps(*t_enter, t_min);
+    *t_exit = _mm256_min_ps(*t_exit, t_max);
+}
+
+__attribute__((target("avx2"))) static uint32_t get_segments_rect_hits_avx2(
+    const SegmentBatch &segments, Rectangle rect, uint8_t *hits, float *dists
+) {
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 x0 = _mm256_set1_ps(rect.x);
+    const __m256 x1 = _mm256_set1_ps(rect.x + rect.width);
+    const __m256 y0 = _mm256_set1_ps(rect.y);
+    const __m256 y1 = _mm256_set1_ps(rect.y + rect.height);
+
+    uint32_t n = segments.start_xs.size() / n_lanes * n_lanes;
+    for (uint32_t i = 0; i < n; i += n_lanes) {
+        __m256 sx = _mm256_loadu_ps(&segments.start_xs[i]);
+        __m256 sy = _mm256_loadu_ps(&segments.start_ys[i]);
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&segments.end_xs[i]), sx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&segments.end_ys[i]), sy);
+
+        __m256 t_enter = _mm256_set1_ps(-INFINITY);
+        __m256 t_exit = inf;
+        clip_slab_avx2(sx, dx, x0, x1, &t_enter, &t_exit);
+        clip_slab_avx2(sy, dy, y0, y1, &t_enter, &t_exit);
+
+        __m256 is_crossed = _mm256_cmp_ps(t_enter, t_exit, _CMP_LE_OQ);
+        __m256 t = _mm256_blendv_ps(inf, t_exit, get_is_unit(t_exit));
+        t = _mm256_blendv_ps(t, t_enter, get_is_unit(t_enter));
+        t = _mm256_blendv_ps(inf, t, is_crossed);
+
+        __m256 is_hit = _mm256_cmp_ps(t, inf, _CMP_LT_OQ);
+        __m256 len = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))
+        );
+        __m256 dist = _mm256_mul_ps(t, len);
+        _mm256_storeu_ps(&dists[i], _mm256_blendv_ps(inf, dist, is_hit));
+        store_hits(&hits[i], is_hit);
+    }
+
+    return n;
+}
+
+__attribute__((target("avx2"))) static uint32_t get_circles_circle_mtvs_avx2(
+    const CircleBatch &circles,
+    Vector2 position,
+    float radius,
+    uint8_t *hits,
+    float *mtv_xs,
+    float *mtv_ys
+) {
+    const __m256 px = _mm256_set1_ps(position.x);
+    const __m256 py = _mm256_set1_ps(position.y);
+    const __m256 r = _mm256_set1_ps(radius);
+    const __m256 eps = _mm256_set1_ps(EPSILON);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    uint32_t n = circles.xs.size() / n_lanes * n_lanes;
+    for (uint32_t i = 0; i < n; i += n_lanes) {
+        __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(&circles.xs[i]));
+        __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(&circles.ys[i]));
+        __m256 radii_sum = _mm256_add_ps(_mm256_loadu_ps(&circles.radii[i]), r);
+        __m256 dist = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))
+        );
+
+        // Coincident centers are pushed along +x
+        __m256 is_far = _mm256_cmp_ps(dist, eps, _CMP_GT_OQ);
+        __m256 inv_dist = _mm256_div_ps(one, dist);
+        __m256 dir_x = _mm256_blendv_ps(one, _mm256_mul_ps(dx, inv_dist), is_far);
+        __m256 dir_y = _mm256_and_ps(_mm256_mul_ps(dy, inv_dist), is_far);
+
+        __m256 is_hit = _mm256_cmp_ps(dist, radii_sum, _CMP_LT_OQ);
+        __m256 push = _mm256_and_ps(_mm256_sub_ps(dist, radii_sum), is_hit);
+        _mm256_storeu_ps(&mtv_xs[i], _mm256_mul_ps(dir_x, push));
+        _mm256_storeu_ps(&mtv_ys[i], _mm256_mul_ps(dir_y, push));
+        store_hits(&hits[i], is_hit);
+    }
+
+    return n;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// batches
+void get_segments_circle_hits(
+    const SegmentBatch &segments,
+    Vector2 position,
+    float radius,
+    std::span<uint8_t> hits,
+    std::span<float> dists
+) {
+    size_t n = segments.start_xs.size();
+    check_sizes(
+        n,
+        {segments.start_ys.size(),
+         segments.end_xs.size(),
+         segments.end_ys.size(),
+         hits.size(),
+         dists.size()}
+    );
+
+    uint32_t i = 0;
+#ifdef GEOMETRY_BATCH_AVX2
+    if (is_geometry_batch_simd()) {
+        i = get_segments_circle_hits_avx2(
+            segments, position, radius, hits.data(), dists.data()
+        );
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float dx = segments.end_xs[i] - segments.start_xs[i];
+        float dy = segments.end_ys[i] - segments.start_ys[i];
+        float fx = segments.start_xs[i] - position.x;
+        float fy = segments.start_ys[i] - position.y;
+        float t = get_segment_circle_t(dx, dy, fx, fy, radius);
+        hits[i] = t < INFINITY;
+        dists[i] = hits[i] ? t * std::sqrt(dx * dx + dy * dy) : INFINITY;
+    }
+}
+
+void get_segments_rect_hits(
+    const SegmentBatch &segments,
+    Rectangle rect,
+    std::span<uint8_t> hits,
+    std::span<float> dists
+) {
+    size_t n = segments.start_xs.size();
+    check_sizes(
+        n,
+        {segments.start_ys.size(),
+         segments.end_xs.size(),
+         segments.end_ys.size(),
+         hits.size(),
+         dists.size()}
+    );
+
+    uint32_t i = 0;
+#ifdef GEOMETRY_BATCH_AVX2
+    if (is_geometry_batch_simd()) {
+        i = get_segments_rect_hits_avx2(segments, rect, hits.data(), dists.data());
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float sx = segments.start_xs[i];
+        float sy = segments.start_ys[i];
+        float dx = segments.end_xs[i] - sx;
+        float dy = segments.end_ys[i] - sy;
+        float t = get_segment_rect_t(sx, sy, dx, dy, rect);
+        hits[i] = t < INFINITY;
+        dists[i] = hits[i] ? t * std::sqrt(dx * dx + dy * dy) : INFINITY;
+    }
+}
+
+void get_circles_circle_mtvs(
+    const CircleBatch &circles,
+    Vector2 position,
+    float radius,
+    std::span<uint8_t> hits,
+    std::span<float> mtv_xs,
+    std::span<float> mtv_ys
+) {
+    size_t n = circles.xs.size();
+    check_sizes(
+        n,
+        {circles.ys.size(),
+         circles.radii.size(),
+         hits.size(),
+         mtv_xs.size(),
+         mtv_ys.size()}
+    );
+
+    uint32_t i = 0;
+#ifdef GEOMETRY_BATCH_AVX2
+    if (is_geometry_batch_simd()) {
+        i = get_circles_circle_mtvs_avx2(
+            circles, position, radius, hits.data(), mtv_xs.data(), mtv_ys.data()
+        );
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float dx = position.x - circles.xs[i];
+        float dy = position.y - circles.ys[i];
+        float radii_sum = circles.radii[i] + radius;
+        float dist = std::sqrt(dx * dx + dy * dy);
+
+        hits[i] = dist < radii_sum;
+        mtv_xs[i] = 0.0f;
+        mtv_ys[i] = 0.0f;
+        if (!hits[i]) continue;
+
+        float push = dist - radii_sum;
+        if (dist > EPSILON) {
+            float inv_dist = 1.0f / dist;
+            mtv_xs[i] = dx * inv_dist * push;
+            mtv_ys[i] = dy * inv_dist * push;
+        } else {
+            mtv_xs[i] = push;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "raylib.h"
+#include <cstdint>
+#include <span>
+
+// Batched variants of the geometry queries: many bodies against one shape,
+// e.g. every projectile of a tick against a circle. The bodies are passed
+// as structure of arrays, so the kernels load 8 lanes at once (AVX2, picked
+// at runtime) with a scalar fallback for the tail and for older CPUs.
+//
+// The per-body results are written in bulk: hits[i] is 1 or 0, the other
+// outputs of a missed body are INFINITY (distances) or zero (mtvs). Output
+// spans must be at least as long as the inputs.
+
+// Segments from (start_xs, start_ys) to (end_xs, end_ys)
+struct SegmentBatch {
+    std::span<const float> start_xs;
+    std::span<const float> start_ys;
+    std::span<const float> end_xs;
+    std::span<const float> end_ys;
+};
+
+// Circles at (xs, ys)
+struct CircleBatch {
+    std::span<const float> xs;
+    std::span<const float> ys;
+    std::span<const float> radii;
+};
+
+// Nearest crossing of every segment with the circle's boundary, as in
+// get_line_circle_intersection_nearest. dists are from the segment start
+void get_segments_circle_hits(
+    const SegmentBatch &segments,
+    Vector2 position,
+    float radius,
+    std::span<uint8_t> hits,
+    std::span<float> dists
+);
+
+// Nearest crossing of every segment with the rect's boundary, as in
+// get_line_rect_intersection_nearest. dists are from the segment start
+void get_segments_rect_hits(
+    const SegmentBatch &segments,
+    Rectangle rect,
+    std::span<uint8_t> hits,
+    std::span<float> dists
+);
+
+// Translation pushing every circle out of the other one, as in
+// get_circle_circle_mtv with the batch circles first
+void get_circles_circle_mtvs(
+    const CircleBatch &circles,
+    Vector2 position,
+    float radius,
+    std::span<uint8_t> hits,
+    std::span<float> mtv_xs,
+    std::span<float> mtv_ys
+);
+
+// Whether the batch queries run the AVX2 kernels on this CPU
+bool is_geometry_batch_simd();
@@ -0,0 +1,131 @@
+#include "grid_changes.hpp"
+
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+uint32_t CellRect::get_n_cells() const {
+    return (this->row1 - this->row0 + 1) * (this->col1 - this->col0 + 1);
+}
+
+static bool is_touching(const CellRect &a, const CellRect &b) {
+    return a.row0 <= b.row1 + 1 && b.row0 <= a.row1 + 1 && a.col0 <= b.col1 + 1
+           && b.col0 <= a.col1 + 1;
+}
+
+static CellRect get_union(const CellRect &a, const CellRect &b) {
+    return {
+        .row0 = std::min(a.row0, b.row0),
+        .col0 = std::min(a.col0, b.col0),
+        .row1 = std::max(a.row1, b.row1),
+        .col1 = std::max(a.col1, b.col1)};
+}
+
+GridChanges::GridChanges(uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , chunk_size(chunk_size)
+    , n_chunk_cols((n_cols + chunk_size - 1) / chunk_size) {
+    uint32_t n_chunk_rows = (n_rows + chunk_size - 1) / chunk_size;
+    this->chunk_rects.resize(n_chunk_rows * this->n_chunk_cols);
+    this->is_chunk_dirty.resize(n_chunk_rows * this->n_chunk_cols, 0);
+}
+
+void GridChanges::subscribe(Subscriber subscriber) {
+    this->subscribers.push_back(std::move(subscriber));
+}
+
+void GridChanges::mark(int32_t row, int32_t col) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return;
+    if (col < 0 || col >= (int32_t)this->n_cols) return;
+
+    uint32_t chunk_idx = row / this->chunk_size * this->n_chunk_cols
+                         + col / this->chunk_size;
+    CellRect &rect = this->chunk_rects[chunk_idx];
+    if (!this->is_chunk_dirty[chunk_idx]) {
+        this->is_chunk_dirty[chunk_idx] = 1;
+        this->dirty_chunk_idxs.push_back(chunk_idx);
+        rect = {.row0 = row, .col0 = col, .row1 = row, .col1 = col};
+        return;
+    }
+
+    rect.row0 = std::min(rect.row0, row);
+    rect.col0 = std::min(rect.col0, col);
+    rect.row1 = std::max(rect.row1, row);
+    rect.col1 = std::max(rect.col1, col);
+}
+
+bool GridChanges::is_empty() const {
+    return this->dirty_chunk_idxs.empty();
+}
+
+void GridChanges::merge_rects() {
+    // Chunk rects in the row-major order, merged along the chunk rows first
+    std::sort(this->dirty_chunk_idxs.begin(), this->dirty_chunk_idxs.end());
+
+    std::vector<CellRect> &row_rects = this->row_rects;
+    row_rects.clear();
+    for (uint32_t chunk_idx : this->dirty_chunk_idxs) {
+        const CellRect &rect = this->chunk_rects[chunk_idx];
+        if (!row_rects.empty()) {
+            CellRect &last = row_rects.back();
+            CellRect merged = get_union(last, rect);
+            if (is_touching(last, rect)
+                && merged.get_n_cells() <= last.get_n_cells() + rect.get_n_cells()) {
+                last = merged;
+                continue;
+            }
+        }
+        row_rects.push_back(rect);
+    }
+
+    // Then down the columns: a rect spanning the same cols as one ending
+    // right above it extends that one, which never adds cells
+    std::unordered_map<uint64_t, uint32_t> &col_span_rects = this->col_span_rects;
+    col_span_rects.clear();
+    this->rects.clear();
+    for (const CellRect &rect : row_rects) {
+        uint64_t key = (uint64_t)(uint32_t)rect.col0 << 32 | (uint32_t)rect.col1;
+        auto it = col_span_rects.find(key);
+        if (it != col_span_rects.end()) {
+            CellRect &above = this->rects[it->second];
+            if (above.row1 + 1 >= rect.row0) {
+                above.row1 = std::max(above.row1, rect.row1);
+                continue;
+            }
+        }
+        col_span_rects[key] = this->rects.size();
+        this->rects.push_back(rect);
+    }
+}
+
+bool GridChanges::flush(ThreadPool &pool, uint32_t min_job_n_cells) {
+    if (this->is_empty()) return false;
+
+    this->merge_rects();
+    for (uint32_t chunk_idx : this->dirty_chunk_idxs) {
+        this->is_chunk_dirty[chunk_idx] = 0;
+    }
+    this->dirty_chunk_idxs.clear();
+
+    // Subscribers may write the grid, those changes go to the next flush
+    std::vector<CellRect> rects = std::move(this->rects);
+    uint32_t n_cells = 0;
+    for (const CellRect &rect : rects) n_cells += rect.get_n_cells();
+
+    if (n_cells < min_job_n_cells) {
+        for (const Subscriber &subscriber : this->subscribers) subscriber(rects);
+    } else {
+        JobFence fence;
+        for (const Subscriber &subscriber : this->subscribers) {
+            pool.submit(fence, [&subscriber, &rects] { subscriber(rects); });
+        }
+        pool.wait(fence);
+    }
+    this->rects = std::move(rects);
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Inclusive range of grid cells
+struct CellRect {
+    int32_t row0;
+    int32_t col0;
+    int32_t row1;
+    int32_t col1;
+
+    uint32_t get_n_cells() const;
+};
+
+// Change bus of a grid: writes mark the changed cells, the data derived from
+// the grid subscribes and catches up on flush(), once for all the changes
+// since the previous one.
+//
+// Every chunk keeps the bounding rect of its changed cells, so marking is
+// O(1). On flush the chunk rects are coalesced: neighbors are merged when
+// the merged rect covers no more cells than the two separately, so a wall
+// run across several chunks is a single rect but two distant edits in a
+// chunk row stay apart.
+//
+// Subscribers must be independent: each one writes its own data and only
+// reads the grid, large flushes run them concurrently.
+class GridChanges {
+public:
+    using Subscriber = std::function<void(const std::vector<CellRect> &rects)>;
+
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t chunk_size;
+    uint32_t n_chunk_cols;
+
+    std::vector<CellRect> chunk_rects;
+    std::vector<uint32_t> dirty_chunk_idxs;
+    std::vector<uint8_t> is_chunk_dirty;
+
+    std::vector<CellRect> rects;
+    std::vector<Subscriber> subscribers;
+
+    // Scratch of the merge: the rects merged along the chunk rows and the
+    // last rect of every col span
+    std::vector<CellRect> row_rects;
+    std::unordered_map<uint64_t, uint32_t> col_span_rects;
+
+    void merge_rects();
+
+public:
+    GridChanges(uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size);
+
+    void subscribe(Subscriber subscriber);
+
+    void mark(int32_t row, int32_t col);
+    bool is_empty() const;
+
+    // Hands the coalesced rects to every subscriber and clears them, as
+    // jobs on the pool once they cover min_job_n_cells, and waits for them.
+    // Returns false if there was nothing to flush
+    bool flush(ThreadPool &pool, uint32_t min_job_n_cells);
+};
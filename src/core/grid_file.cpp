@@ -0,0 +1,249 @@
+#include "grid_file.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static constexpr uint32_t magic = 0x46475354;  // "TSGF"
+static constexpr uint32_t version = 1;
+
+// -----------------------------------------------------------------------
+// run-length encoding: (run length varint, value byte) pairs
+static void write_varint(std::vector<uint8_t> &data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    data.push_back(value);
+}
+
+static void encode_rle(const uint8_t *values, uint32_t n, std::vector<uint8_t> &data) {
+    for (uint32_t i = 0; i < n;) {
+        uint32_t run = 1;
+        while (i + run < n && values[i + run] == values[i]) ++run;
+        write_varint(data, run);
+        data.push_back(values[i]);
+        i += run;
+    }
+}
+
+static void decode_rle(
+    const uint8_t *data, size_t size, uint8_t *values, uint32_t n
+) {
+    size_t pos = 0;
+    uint32_t i = 0;
+    while (pos < size && i < n) {
+        uint32_t run = 0;
+        for (uint32_t shift = 0; pos < size; shift += 7) {
+            uint8_t byte = data[pos++];
+            run |= (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (pos >= size || run > n - i) {
+            throw std::runtime_error("Corrupted grid file chunk");
+        }
+
+        std::memset(values + i, data[pos++], run);
+        i += run;
+    }
+
+    if (i != n) throw std::runtime_error("Corrupted grid file chunk");
+}
+
+// -----------------------------------------------------------------------
+// writer
+void save_grid_file(
+    std::string file_path,
+    uint32_t n_rows,
+    uint32_t n_cols,
+    uint32_t chunk_size,
+    uint32_t n_planes,
+    const GridChunkSource &get_chunk,
+    const std::vector<uint8_t> &blob
+) {
+    uint32_t n_chunk_rows = (n_rows + chunk_size - 1) / chunk_size;
+    uint32_t n_chunk_cols = (n_cols + chunk_size - 1) / chunk_size;
+    uint32_t n_chunks = n_chunk_rows * n_chunk_cols;
+    uint32_t n_chunk_cells = chunk_size * chunk_size;
+
+    // Written next to the target and renamed over it once complete, so a
+    // failed save leaves the previous file as it was
+    std::string tmp_path = file_path + ".tmp";
+    auto write = [&]() {
+        std::ofstream file(tmp_path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + tmp_path);
+        }
+
+        // The header and the chunk table are written once the offsets are
+        // known, the chunks go straight to the file meanwhile
+        std::vector<GridFile::ChunkEntry> entries(n_chunks, {0, 0});
+        uint64_t offset = sizeof(GridFile::Header)
+                          + n_chunks * sizeof(GridFile::ChunkEntry);
+        file.seekp(offset);
+
+        std::vector<uint8_t> planes;
+        std::vector<uint8_t> payload;
+        for (uint32_t chunk_idx = 0; chunk_idx < n_chunks; ++chunk_idx) {
+            uint32_t row0 = chunk_idx / n_chunk_cols * chunk_size;
+            uint32_t col0 = chunk_idx % n_chunk_cols * chunk_size;
+            planes.assign(n_planes * n_chunk_cells, 0);
+            get_chunk(row0, col0, planes);
+
+            bool is_empty = std::all_of(
+                planes.begin(), planes.end(), [](uint8_t v) { return v == 0; }
+            );
+            if (is_empty) continue;
+
+            payload.clear();
+            for (uint32_t i = 0; i < n_planes; ++i) {
+                encode_rle(&planes[i * n_chunk_cells], n_chunk_cells, payload);
+            }
+            file.write((const char *)payload.data(), payload.size());
+            entries[chunk_idx] = {.offset = offset, .size = payload.size()};
+            offset += payload.size();
+        }
+        file.write((const char *)blob.data(), blob.size());
+
+        GridFile::Header header = {
+            .magic = magic,
+            .version = version,
+            .n_rows = n_rows,
+            .n_cols = n_cols,
+            .chunk_size = chunk_size,
+            .n_planes = n_planes,
+            .blob_offset = offset,
+            .blob_size = blob.size()};
+        file.seekp(0);
+        file.write((const char *)&header, sizeof(header));
+        file.write(
+            (const char *)entries.data(), entries.size() * sizeof(entries[0])
+        );
+        file.close();
+        if (file.fail()) {
+            throw std::runtime_error("Failed to write file: " + tmp_path);
+        }
+    };
+
+    try {
+        write();
+    } catch (...) {
+        std::remove(tmp_path.c_str());
+        throw;
+    }
+    if (std::rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to replace file: " + file_path);
+    }
+}
+
+// -----------------------------------------------------------------------
+// reader
+GridFile::GridFile(std::string file_path) {
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open file: " + file_path);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            this->data = (const uint8_t *)data;
+            this->size = st.st_size;
+        }
+    }
+    close(fd);
+
+    auto fail = [&](std::string message) {
+        if (this->data) munmap((void *)this->data, this->size);
+        throw std::runtime_error(message + file_path);
+    };
+    if (!this->data || this->size < sizeof(Header)) fail("Failed to map file: ");
+
+    std::memcpy(&this->header, this->data, sizeof(Header));
+    const Header &h = this->header;
+    bool is_valid = h.magic == magic && h.version == version && h.chunk_size > 0;
+    if (is_valid) {
+        this->n_chunk_rows = (h.n_rows + h.chunk_size - 1) / h.chunk_size;
+        this->n_chunk_cols = (h.n_cols + h.chunk_size - 1) / h.chunk_size;
+        uint64_t n_chunks = (uint64_t)this->n_chunk_rows * this->n_chunk_cols;
+        uint64_t table_end = sizeof(Header) + n_chunks * sizeof(ChunkEntry);
+        is_valid = table_end <= this->size
+                   && h.blob_offset + h.blob_size <= this->size;
+        if (is_valid) {
+            this->chunk_entries.resize(n_chunks);
+            std::memcpy(
+                this->chunk_entries.data(),
+                this->data + sizeof(Header),
+                n_chunks * sizeof(ChunkEntry)
+            );
+        }
+    }
+    for (const ChunkEntry &entry : this->chunk_entries) {
+        is_valid &= entry.offset + entry.size <= this->size;
+    }
+
+    if (!is_valid) fail("Invalid grid file: ");
+}
+
+GridFile::~GridFile() {
+    munmap((void *)this->data, this->size);
+}
+
+uint32_t GridFile::get_n_rows() const {
+    return this->header.n_rows;
+}
+
+uint32_t GridFile::get_n_cols() const {
+    return this->header.n_cols;
+}
+
+uint32_t GridFile::get_chunk_size() const {
+    return this->header.chunk_size;
+}
+
+uint32_t GridFile::get_n_planes() const {
+    return this->header.n_planes;
+}
+
+uint32_t GridFile::get_n_chunks() const {
+    return this->chunk_entries.size();
+}
+
+uint32_t GridFile::get_chunk_row(uint32_t chunk_idx) const {
+    return chunk_idx / this->n_chunk_cols * this->header.chunk_size;
+}
+
+uint32_t GridFile::get_chunk_col(uint32_t chunk_idx) const {
+    return chunk_idx % this->n_chunk_cols * this->header.chunk_size;
+}
+
+bool GridFile::is_chunk_empty(uint32_t chunk_idx) const {
+    return this->chunk_entries[chunk_idx].size == 0;
+}
+
+void GridFile::decode_chunk(uint32_t chunk_idx, std::vector<uint8_t> &planes) const {
+    uint32_t n_chunk_cells = this->header.chunk_size * this->header.chunk_size;
+    planes.assign(n_chunk_cells * this->header.n_planes, 0);
+
+    // Planes are encoded back to back, each decodes exactly n_chunk_cells
+    const ChunkEntry &entry = this->chunk_entries[chunk_idx];
+    const uint8_t *src = this->data + entry.offset;
+    if (entry.size > 0) {
+        decode_rle(src, entry.size, planes.data(), planes.size());
+    }
+}
+
+std::vector<uint8_t> GridFile::get_blob() const {
+    const uint8_t *blob = this->data + this->header.blob_offset;
+    return std::vector<uint8_t>(blob, blob + this->header.blob_size);
+}
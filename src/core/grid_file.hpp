@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Chunked grid snapshot on disk. The grid is stored as byte planes (one
+// byte per cell each, e.g. the item type and the sprite), split into square
+// chunks. Every chunk is run-length encoded on its own and chunks whose
+// planes are all zero aren't stored at all. An opaque blob follows the
+// chunks for the non-grid state.
+//
+// The writer asks for the planes a chunk at a time and streams them to a
+// temporary file, renamed over the target once complete. The reader maps
+// the file and decodes one chunk at a time, when asked, into the caller's
+// buffer: nothing is decoded ahead or kept.
+
+// Fills the planes of the chunk whose first cell is (row0, col0), one after
+// another in the layout GridFile::decode_chunk() returns. They come zeroed
+using GridChunkSource = std::function<
+    void(uint32_t row0, uint32_t col0, std::vector<uint8_t> &planes)>;
+
+void save_grid_file(
+    std::string file_path,
+    uint32_t n_rows,
+    uint32_t n_cols,
+    uint32_t chunk_size,
+    uint32_t n_planes,
+    const GridChunkSource &get_chunk,
+    const std::vector<uint8_t> &blob
+);
+
+class GridFile {
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t n_rows;
+        uint32_t n_cols;
+        uint32_t chunk_size;
+        uint32_t n_planes;
+        uint64_t blob_offset;
+        uint64_t blob_size;
+    };
+
+    struct ChunkEntry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+    Header header;
+    uint32_t n_chunk_rows;
+    uint32_t n_chunk_cols;
+    std::vector<ChunkEntry> chunk_entries;
+
+    friend void save_grid_file(
+        std::string file_path,
+        uint32_t n_rows,
+        uint32_t n_cols,
+        uint32_t chunk_size,
+        uint32_t n_planes,
+        const GridChunkSource &get_chunk,
+        const std::vector<uint8_t> &blob
+    );
+
+public:
+    // Throws if the file can't be mapped or isn't a grid file
+    explicit GridFile(std::string file_path);
+    ~GridFile();
+
+    GridFile(const GridFile &) = delete;
+    GridFile &operator=(const GridFile &) = delete;
+
+    uint32_t get_n_rows() const;
+    uint32_t get_n_cols() const;
+    uint32_t get_chunk_size() const;
+    uint32_t get_n_planes() const;
+    uint32_t get_n_chunks() const;
+
+    // Chunks are row-major, their cells cover rows
+    // [row, row + chunk_size) and cols [col, col + chunk_size), clipped
+    // to the grid
+    uint32_t get_chunk_row(uint32_t chunk_idx) const;
+    uint32_t get_chunk_col(uint32_t chunk_idx) const;
+
+    // Empty chunks have all planes zero and need no decoding
+    bool is_chunk_empty(uint32_t chunk_idx) const;
+
+    // The chunk's planes one after another, chunk_size x chunk_size bytes
+    // each (row-major, the cells past the grid edge are zero). Throws if
+    // the chunk is corrupted
+    void decode_chunk(uint32_t chunk_idx, std::vector<uint8_t> &planes) const;
+
+    std::vector<uint8_t> get_blob() const;
+};
@@ -0,0 +1,51 @@
+#include "grid_mask.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+GridMask::GridMask()
+    : n_rows(0)
+    , n_cols(0) {}
+
+GridMask::GridMask(uint32_t n_rows, uint32_t n_cols)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , words((n_rows * n_cols + 63) / 64, 0) {}
+
+uint32_t GridMask::get_n_rows() const {
+    return this->n_rows;
+}
+
+uint32_t GridMask::get_n_cols() const {
+    return this->n_cols;
+}
+
+bool GridMask::get(int32_t row, int32_t col) const {
+    if (row < 0 || row >= (int32_t)this->n_rows) return false;
+    if (col < 0 || col >= (int32_t)this->n_cols) return false;
+
+    uint32_t idx = row * this->n_cols + col;
+    return (this->words[idx / 64] >> (idx % 64)) & 1;
+}
+
+void GridMask::set(int32_t row, int32_t col, bool value) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return;
+    if (col < 0 || col >= (int32_t)this->n_cols) return;
+
+    uint32_t idx = row * this->n_cols + col;
+    uint64_t bit = (uint64_t)1 << (idx % 64);
+    if (value) this->words[idx / 64] |= bit;
+    else this->words[idx / 64] &= ~bit;
+}
+
+void GridMask::clear() {
+    std::fill(this->words.begin(), this->words.end(), 0);
+}
+
+uint32_t GridMask::count() const {
+    uint32_t n = 0;
+    for (uint64_t word : this->words) n += std::popcount(word);
+    return n;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One bit per grid cell, row-major. Out of bounds cells read as unset
+class GridMask {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    std::vector<uint64_t> words;
+
+public:
+    GridMask();
+    GridMask(uint32_t n_rows, uint32_t n_cols);
+
+    uint32_t get_n_rows() const;
+    uint32_t get_n_cols() const;
+
+    bool get(int32_t row, int32_t col) const;
+    void set(int32_t row, int32_t col, bool value);
+    void clear();
+    uint32_t count() const;
+};
@@ -0,0 +1,106 @@
+#include "grid_ray.hpp"
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+// Clips the parameter range to the slab 0 <= s + t * d <= size. The side
+// the range is entered through is kept as the normal
+static void clip_slab(
+    float s,
+    float d,
+    float size,
+    Vector2 axis,
+    float *t_enter,
+    float *t_exit,
+    Vector2 *normal
+) {
+    if (d == 0.0f) {
+        if (s < 0.0f || s > size) *t_enter = INFINITY;
+        return;
+    }
+
+    float t0 = (0.0f - s) / d;
+    float t1 = (size - s) / d;
+    if (t0 > t1) std::swap(t0, t1);
+    if (t0 > *t_enter) {
+        *t_enter = t0;
+        *normal = d > 0.0f ? Vector2{-axis.x, -axis.y} : axis;
+    }
+    *t_exit = std::min(*t_exit, t1);
+}
+
+bool cast_grid_ray(
+    const GridMask &blockers, Vector2 origin, Vector2 start, Vector2 end, GridRayHit *hit
+) {
+    int32_t n_rows = blockers.get_n_rows();
+    int32_t n_cols = blockers.get_n_cols();
+
+    // Grid space: cells are the unit squares at integer coordinates
+    float x = start.x - origin.x;
+    float y = start.y - origin.y;
+    float dx = end.x - start.x;
+    float dy = end.y - start.y;
+
+    float t = 0.0;
+    float t_exit = 1.0;
+    Vector2 normal = {0.0, 0.0};
+    clip_slab(x, dx, n_cols, {1.0, 0.0}, &t, &t_exit, &normal);
+    clip_slab(y, dy, n_rows, {0.0, 1.0}, &t, &t_exit, &normal);
+    if (t > t_exit) return false;
+
+    auto get_cell = [](float k, int32_t n) {
+        return std::clamp((int32_t)std::floor(k), 0, n - 1);
+    };
+    int32_t col = get_cell(x + t * dx, n_cols);
+    int32_t row = get_cell(y + t * dy, n_rows);
+    int32_t end_col = get_cell(x + t_exit * dx, n_cols);
+    int32_t end_row = get_cell(y + t_exit * dy, n_rows);
+    int32_t n_steps = std::abs(end_col - col) + std::abs(end_row - row);
+
+    // Parameters of the next vertical and horizontal grid line crossings
+    // and the distance between two of them
+    int32_t step_col = dx > 0.0f ? 1 : -1;
+    int32_t step_row = dy > 0.0f ? 1 : -1;
+    float t_delta_x = dx != 0.0f ? std::fabs(1.0f / dx) : INFINITY;
+    float t_delta_y = dy != 0.0f ? std::fabs(1.0f / dy) : INFINITY;
+    float t_max_x = INFINITY;
+    float t_max_y = INFINITY;
+    if (dx != 0.0f) t_max_x = ((float)(dx > 0.0f ? col + 1 : col) - x) / dx;
+    if (dy != 0.0f) t_max_y = ((float)(dy > 0.0f ? row + 1 : row) - y) / dy;
+
+    for (int32_t i = 0;; ++i) {
+        if (blockers.get(row, col)) {
+            Vector2 point = {x + t * dx, y + t * dy};
+
+            // Exactly on the entered grid line
+            if (normal.x != 0.0f) point.x = normal.x < 0.0f ? col : col + 1;
+            if (normal.y != 0.0f) point.y = normal.y < 0.0f ? row : row + 1;
+
+            *hit = {
+                .row = row,
+                .col = col,
+                .point = {origin.x + point.x, origin.y + point.y},
+                .normal = normal,
+                .dist = t * std::sqrt(dx * dx + dy * dy)};
+            return true;
+        }
+        if (i == n_steps) return false;
+
+        if (t_max_x < t_max_y) {
+            col += step_col;
+            t = t_max_x;
+            t_max_x += t_delta_x;
+            normal = {(float)-step_col, 0.0};
+        } else {
+            row += step_row;
+            t = t_max_y;
+            t_max_y += t_delta_y;
+            normal = {0.0, (float)-step_row};
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <cstdint>
+
+// First blocking cell along a ray. The point is where the ray enters the
+// cell and the normal is the one of the entered side. A ray which starts
+// inside a blocking cell hits at its start with a zero normal
+struct GridRayHit {
+    int32_t row;
+    int32_t col;
+    Vector2 point;
+    Vector2 normal;
+    float dist;
+};
+
+// Grid traversal (Amanatides-Woo DDA) of the unit cells the segment from
+// start to end crosses, in order, so the cost is the number of cells
+// crossed. The segment is clipped to the grid first, cells out of it don't
+// block. origin is the world position of the grid's top left corner
+bool cast_grid_ray(
+    const GridMask &blockers, Vector2 origin, Vector2 start, Vector2 end, GridRayHit *hit
+);
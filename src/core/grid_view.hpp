@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Neighbor offsets around a cell. Stencils are constexpr values, so the
+// loops over them unroll and the radius (how far the offsets reach) is
+// known upfront
+template <size_t N>
+struct Stencil {
+    std::array<int32_t, N> d_rows;
+    std::array<int32_t, N> d_cols;
+
+    constexpr int32_t get_radius() const {
+        int32_t radius = 0;
+        for (size_t i = 0; i < N; ++i) {
+            radius = std::max({radius, d_rows[i], -d_rows[i], d_cols[i], -d_cols[i]});
+        }
+        return radius;
+    }
+};
+
+// Left, then clockwise, same order as CellNeighbors and the flow field dirs
+namespace stencils {
+inline constexpr Stencil<4> von_neumann = {
+    .d_rows = {0, -1, 0, 1},
+    .d_cols = {-1, 0, 1, 0},
+};
+inline constexpr Stencil<8> moore = {
+    .d_rows = {0, -1, -1, -1, 0, 1, 1, 1},
+    .d_cols = {-1, -1, 0, 1, 1, 1, 0, -1},
+};
+}  // namespace stencils
+
+// Integer-coordinate view of a row-major grid, it doesn't own the cells.
+//
+// Neighbors are gathered as pointers in the stencil order. Cells at least
+// the stencil radius away from the border (almost all of them) take the
+// unchecked path: the center index plus the row-major stencil offsets.
+// Only the border ring checks every neighbor, the ones out of the grid read
+// as nullptr, as if the grid were padded with empty cells
+template <typename T>
+class GridView {
+private:
+    T *data;
+    int32_t n_rows;
+    int32_t n_cols;
+
+public:
+    GridView(T *data, uint32_t n_rows, uint32_t n_cols)
+        : data(data)
+        , n_rows(n_rows)
+        , n_cols(n_cols) {}
+
+    bool contains(int32_t row, int32_t col) const {
+        return (uint32_t)row < (uint32_t)this->n_rows
+               && (uint32_t)col < (uint32_t)this->n_cols;
+    }
+
+    T *get(int32_t row, int32_t col) const {
+        if (!this->contains(row, col)) return nullptr;
+        return &this->data[row * this->n_cols + col];
+    }
+
+    template <size_t N>
+    std::array<T *, N> gather(int32_t row, int32_t col, const Stencil<N> &stencil) const {
+        std::array<T *, N> cells;
+
+        int32_t radius = stencil.get_radius();
+        if (row >= radius && row < this->n_rows - radius && col >= radius
+            && col < this->n_cols - radius) {
+            T *center = &this->data[row * this->n_cols + col];
+            for (size_t i = 0; i < N; ++i) {
+                cells[i] = center + stencil.d_rows[i] * this->n_cols + stencil.d_cols[i];
+            }
+            return cells;
+        }
+
+        for (size_t i = 0; i < N; ++i) {
+            cells[i] = this->get(row + stencil.d_rows[i], col + stencil.d_cols[i]);
+        }
+        return cells;
+    }
+
+    // Calls func(row, col, cell, neighbors) for every cell of the inclusive
+    // region clipped to the grid, row by row
+    template <size_t N, typename Func>
+    void for_each(
+        int32_t row0,
+        int32_t col0,
+        int32_t row1,
+        int32_t col1,
+        const Stencil<N> &stencil,
+        Func func
+    ) const {
+        row0 = std::max(row0, 0);
+        col0 = std::max(col0, 0);
+        row1 = std::min(row1, this->n_rows - 1);
+        col1 = std::min(col1, this->n_cols - 1);
+        for (int32_t row = row0; row <= row1; ++row) {
+            for (int32_t col = col0; col <= col1; ++col) {
+                T *cell = &this->data[row * this->n_cols + col];
+                func(row, col, cell, this->gather(row, col, stencil));
+            }
+        }
+    }
+};
@@ -0,0 +1,119 @@
+#include "impostor_atlas.hpp"
+
+#include "raylib.h"
+#include "rlgl.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+ImpostorAtlas::ImpostorAtlas(uint32_t size, uint32_t slot_size)
+    : slot_size(slot_size)
+    , n_slot_cols(size / slot_size)
+    , n_slots(n_slot_cols * n_slot_cols) {
+    this->target = LoadRenderTexture(size, size);
+    SetTextureFilter(this->target.texture, TEXTURE_FILTER_BILINEAR);
+
+    BeginTextureMode(this->target);
+    ClearBackground(BLANK);
+    EndTextureMode();
+
+    this->slots.reserve(this->n_slots);
+}
+
+ImpostorAtlas::~ImpostorAtlas() {
+    UnloadRenderTexture(this->target);
+}
+
+void ImpostorAtlas::begin_frame() {
+    this->frame += 1;
+}
+
+int32_t ImpostorAtlas::find_slot(uint64_t key) {
+    auto it = this->slot_idxs.find(key);
+    if (it == this->slot_idxs.end()) return -1;
+
+    this->slots[it->second].last_frame = this->frame;
+    return it->second;
+}
+
+int32_t ImpostorAtlas::acquire_slot(uint64_t key) {
+    int32_t slot_idx = -1;
+    if (this->slots.size() < this->n_slots) {
+        slot_idx = this->slots.size();
+        this->slots.push_back({});
+    } else {
+        // A free slot, otherwise the least recently used one
+        uint64_t min_frame = this->frame;
+        for (uint32_t i = 0; i < this->slots.size(); ++i) {
+            const Slot &slot = this->slots[i];
+            if (!slot.is_used) {
+                slot_idx = i;
+                break;
+            }
+            if (slot.last_frame < min_frame) {
+                min_frame = slot.last_frame;
+                slot_idx = i;
+            }
+        }
+        if (slot_idx == -1) return -1;
+
+        Slot &slot = this->slots[slot_idx];
+        if (slot.is_used) this->slot_idxs.erase(slot.key);
+    }
+
+    this->slots[slot_idx] = {
+        .key = key, .version = 0, .last_frame = this->frame, .is_used = true};
+    this->slot_idxs[key] = slot_idx;
+    return slot_idx;
+}
+
+void ImpostorAtlas::release_slot(uint64_t key) {
+    auto it = this->slot_idxs.find(key);
+    if (it == this->slot_idxs.end()) return;
+
+    this->slots[it->second].is_used = false;
+    this->slot_idxs.erase(it);
+}
+
+uint32_t ImpostorAtlas::get_slot_version(uint32_t slot_idx) const {
+    return this->slots[slot_idx].version;
+}
+
+void ImpostorAtlas::set_slot_version(uint32_t slot_idx, uint32_t version) {
+    this->slots[slot_idx].version = version;
+}
+
+void ImpostorAtlas::begin_update() {
+    BeginTextureMode(this->target);
+}
+
+void ImpostorAtlas::begin_slot(uint32_t slot_idx) {
+    // The previous slot is drawn before the viewport moves
+    rlDrawRenderBatchActive();
+
+    int x = slot_idx % this->n_slot_cols * this->slot_size;
+    int y = slot_idx / this->n_slot_cols * this->slot_size;
+    int size = this->slot_size;
+    rlViewport(x, y, size, size);
+
+    rlEnableScissorTest();
+    rlScissor(x, y, size, size);
+    rlClearColor(0, 0, 0, 0);
+    rlClearScreenBuffers();
+    rlDisableScissorTest();
+}
+
+void ImpostorAtlas::end_update() {
+    EndTextureMode();
+}
+
+void ImpostorAtlas::draw_slot(uint32_t slot_idx, Rectangle dst) {
+    // Render textures are bottom-up, the negative height flips the slot
+    float size = this->slot_size;
+    Rectangle src = {
+        .x = (float)(slot_idx % this->n_slot_cols) * size,
+        .y = (float)(slot_idx / this->n_slot_cols) * size,
+        .width = size,
+        .height = -size};
+    DrawTexturePro(this->target.texture, src, dst, {0.0, 0.0}, 0.0, BLANK);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "raylib.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Pre-rendered low-res images (impostors) of whatever the caller keys them
+// by, e.g. a grid chunk of a layer, packed as square slots of one render
+// texture. Far views draw a quad per impostor instead of everything under
+// it, so their cost doesn't grow with the content.
+//
+// A slot keeps the version of what it shows: the caller redraws it once
+// its source moved on. When the atlas is full, the slot used the longest
+// ago is recycled, never one used in the current frame.
+class ImpostorAtlas {
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t version;
+        uint64_t last_frame;
+        bool is_used;
+    };
+
+    RenderTexture2D target;
+    uint32_t slot_size;
+    uint32_t n_slot_cols;
+    uint32_t n_slots;
+
+    // Grows up to n_slots, then slots are reused
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, uint32_t> slot_idxs;
+    uint64_t frame = 1;
+
+public:
+    ImpostorAtlas(const ImpostorAtlas &) = delete;
+    ImpostorAtlas &operator=(const ImpostorAtlas &) = delete;
+
+    // Needs the GL context, size and slot_size are in pixels
+    ImpostorAtlas(uint32_t size, uint32_t slot_size);
+    ~ImpostorAtlas();
+
+    void begin_frame();
+
+    // Slot of the key, marked as used this frame, -1 if it has none
+    int32_t find_slot(uint64_t key);
+
+    // New slot for the key (version 0, so stale), -1 if every slot is used
+    // this frame
+    int32_t acquire_slot(uint64_t key);
+    void release_slot(uint64_t key);
+
+    uint32_t get_slot_version(uint32_t slot_idx) const;
+    void set_slot_version(uint32_t slot_idx, uint32_t version);
+
+    // Slot redraws: between begin_update() and end_update(), begin_slot()
+    // clears the slot and points the viewport at it. The caller sets a
+    // square camera over the slot content and draws it
+    void begin_update();
+    void begin_slot(uint32_t slot_idx);
+    void end_update();
+
+    void draw_slot(uint32_t slot_idx, Rectangle dst);
+};
@@ -0,0 +1,19 @@
+#include "json_utils.hpp"
+
+#include "json.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using json = nlohmann::json;
+
+json load_json(std::string file_path) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path);
+    }
+
+    auto data = json::parse(file);
+    file.close();
+    return data;
+}
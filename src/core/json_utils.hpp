@@ -0,0 +1,6 @@
+#pragma once
+
+#include "json.hpp"
+#include <string>
+
+nlohmann::json load_json(std::string file_path);
@@ -0,0 +1,573 @@
+#include "path_graph.hpp"
+
+#include "terrain.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Same neighbor order as the flow field: left, then clockwise. Even
+// directions are orthogonal, odd ones are diagonal
+static const int32_t dir_rows[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+static const int32_t dir_cols[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+static const float dir_lens[8] = {
+    1.0, M_SQRT2, 1.0, M_SQRT2, 1.0, M_SQRT2, 1.0, M_SQRT2};
+static constexpr uint32_t no_idx = UINT32_MAX;
+
+// Min-heap order of the open lists. Only the estimated total cost counts,
+// ties are left in any order (cheaper than comparing the whole tuple)
+static bool is_heap_item_after(
+    const std::tuple<float, float, uint32_t> &lhs,
+    const std::tuple<float, float, uint32_t> &rhs
+) {
+    return std::get<0>(lhs) > std::get<0>(rhs);
+}
+
+// Passable runs of at least this length get an entrance at each end
+static constexpr uint32_t min_double_entrance_len = 10;
+
+PathGraph::PathGraph(
+    uint32_t n_rows, uint32_t n_cols, uint32_t cluster_size, float door_cost
+)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , cluster_size(cluster_size)
+    , n_cluster_rows((n_rows + cluster_size - 1) / cluster_size)
+    , n_cluster_cols((n_cols + cluster_size - 1) / cluster_size)
+    , n_cluster_node_ids(4 * cluster_size)
+    , door_cost(door_cost)
+    , terrain(n_rows * n_cols, Terrain::FLOOR) {
+
+    uint32_t n_clusters = this->n_cluster_rows * this->n_cluster_cols;
+    this->clusters.resize(n_clusters);
+    this->h_borders.resize(n_clusters);
+    this->v_borders.resize(n_clusters);
+    this->is_cluster_dirty.assign(n_clusters, 0);
+    this->is_h_border_dirty.assign(n_clusters, 0);
+    this->is_v_border_dirty.assign(n_clusters, 0);
+
+    for (uint32_t cluster_idx = 0; cluster_idx < n_clusters; ++cluster_idx) {
+        Bounds &bounds = this->clusters[cluster_idx].bounds;
+        bounds.row = cluster_idx / this->n_cluster_cols * cluster_size;
+        bounds.col = cluster_idx % this->n_cluster_cols * cluster_size;
+        bounds.n_rows = std::min(cluster_size, n_rows - bounds.row);
+        bounds.n_cols = std::min(cluster_size, n_cols - bounds.col);
+
+        this->mark_cluster(cluster_idx);
+        this->mark_h_border(cluster_idx);
+        this->mark_v_border(cluster_idx);
+    }
+
+    this->search_nodes.assign(n_clusters * this->n_cluster_node_ids + 2, {});
+}
+
+// -----------------------------------------------------------------------
+// grid
+float PathGraph::get_cost(uint32_t idx) {
+    switch (this->terrain[idx]) {
+        case Terrain::FLOOR: return 1.0;
+        case Terrain::DOOR: return this->door_cost < 0.0 ? INFINITY : this->door_cost;
+        case Terrain::WALL: return INFINITY;
+    }
+    return INFINITY;
+}
+
+float PathGraph::get_heuristic(uint32_t idx, uint32_t goal_idx) {
+    // Octile distance scaled by the cheapest step, so it never overestimates
+    float min_cost = this->door_cost < 0.0 ? 1.0 : std::min(1.0f, this->door_cost);
+    int32_t row = idx / this->n_cols;
+    int32_t col = idx % this->n_cols;
+    int32_t goal_row = goal_idx / this->n_cols;
+    int32_t goal_col = goal_idx % this->n_cols;
+    float d_row = std::abs(row - goal_row);
+    float d_col = std::abs(col - goal_col);
+    float d_min = std::min(d_row, d_col);
+    float d_max = std::max(d_row, d_col);
+    return min_cost * (d_max - d_min + d_min * (float)M_SQRT2);
+}
+
+// -----------------------------------------------------------------------
+// clusters
+uint32_t PathGraph::get_cluster_idx(uint32_t idx) {
+    uint32_t cluster_row = idx / this->n_cols / this->cluster_size;
+    uint32_t cluster_col = idx % this->n_cols / this->cluster_size;
+    return cluster_row * this->n_cluster_cols + cluster_col;
+}
+
+uint32_t PathGraph::get_local_idx(const Bounds &bounds, uint32_t idx) {
+    uint32_t row = idx / this->n_cols - bounds.row + 1;
+    uint32_t col = idx % this->n_cols - bounds.col + 1;
+    return row * (bounds.n_cols + 2) + col;
+}
+
+float PathGraph::get_local_dist(const Bounds &bounds, uint32_t idx) {
+    return this->local_dists[this->get_local_idx(bounds, idx)];
+}
+
+int32_t PathGraph::find_node(const Cluster &cluster, uint32_t idx) {
+    for (uint32_t i = 0; i < cluster.nodes.size(); ++i) {
+        if (cluster.nodes[i].idx == idx) return i;
+    }
+
+    return -1;
+}
+
+void PathGraph::mark_cluster(uint32_t cluster_idx) {
+    if (this->is_cluster_dirty[cluster_idx]) return;
+    this->is_cluster_dirty[cluster_idx] = 1;
+    this->dirty_cluster_idxs.push_back(cluster_idx);
+}
+
+void PathGraph::mark_h_border(uint32_t cluster_idx) {
+    if (cluster_idx / this->n_cluster_cols + 1 >= this->n_cluster_rows) return;
+    if (this->is_h_border_dirty[cluster_idx]) return;
+    this->is_h_border_dirty[cluster_idx] = 1;
+    this->dirty_h_border_idxs.push_back(cluster_idx);
+}
+
+void PathGraph::mark_v_border(uint32_t cluster_idx) {
+    if (cluster_idx % this->n_cluster_cols + 1 >= this->n_cluster_cols) return;
+    if (this->is_v_border_dirty[cluster_idx]) return;
+    this->is_v_border_dirty[cluster_idx] = 1;
+    this->dirty_v_border_idxs.push_back(cluster_idx);
+}
+
+void PathGraph::add_entrances(
+    std::vector<Entrance> &entrances,
+    uint32_t idx_a,
+    uint32_t along_step,
+    uint32_t across_step,
+    uint32_t n
+) {
+    entrances.clear();
+
+    uint32_t run_start = 0;
+    for (uint32_t i = 0; i <= n; ++i) {
+        uint32_t a = idx_a + i * along_step;
+        bool is_open = i < n && !std::isinf(this->get_cost(a))
+                       && !std::isinf(this->get_cost(a + across_step));
+        if (is_open) continue;
+
+        uint32_t run_len = i - run_start;
+        if (run_len >= min_double_entrance_len) {
+            uint32_t first = idx_a + run_start * along_step;
+            uint32_t last = idx_a + (i - 1) * along_step;
+            entrances.push_back({first, first + across_step});
+            entrances.push_back({last, last + across_step});
+        } else if (run_len > 0) {
+            uint32_t mid = idx_a + (run_start + run_len / 2) * along_step;
+            entrances.push_back({mid, mid + across_step});
+        }
+        run_start = i + 1;
+    }
+}
+
+void PathGraph::build_h_border(uint32_t cluster_idx) {
+    const Bounds &bounds = this->clusters[cluster_idx].bounds;
+    uint32_t row = bounds.row + bounds.n_rows - 1;
+    this->add_entrances(
+        this->h_borders[cluster_idx],
+        row * this->n_cols + bounds.col,
+        1,
+        this->n_cols,
+        bounds.n_cols
+    );
+
+    this->mark_cluster(cluster_idx);
+    this->mark_cluster(cluster_idx + this->n_cluster_cols);
+}
+
+void PathGraph::build_v_border(uint32_t cluster_idx) {
+    const Bounds &bounds = this->clusters[cluster_idx].bounds;
+    uint32_t col = bounds.col + bounds.n_cols - 1;
+    this->add_entrances(
+        this->v_borders[cluster_idx],
+        bounds.row * this->n_cols + col,
+        this->n_cols,
+        1,
+        bounds.n_rows
+    );
+
+    this->mark_cluster(cluster_idx);
+    this->mark_cluster(cluster_idx + 1);
+}
+
+void PathGraph::build_cluster(uint32_t cluster_idx) {
+    Cluster &cluster = this->clusters[cluster_idx];
+    cluster.nodes.clear();
+    cluster.links.clear();
+
+    // -------------------------------------------------------------------
+    // Nodes are the cluster sides of the entrances on its four borders
+    auto &entrances = this->cluster_entrances;
+    entrances.clear();
+    uint32_t cluster_row = cluster_idx / this->n_cluster_cols;
+    uint32_t cluster_col = cluster_idx % this->n_cluster_cols;
+    if (cluster_row > 0) {
+        for (Entrance e : this->h_borders[cluster_idx - this->n_cluster_cols]) {
+            entrances.push_back({e.idx_b, e.idx_a});
+        }
+    }
+    if (cluster_col > 0) {
+        for (Entrance e : this->v_borders[cluster_idx - 1]) {
+            entrances.push_back({e.idx_b, e.idx_a});
+        }
+    }
+    for (Entrance e : this->h_borders[cluster_idx]) entrances.push_back(e);
+    for (Entrance e : this->v_borders[cluster_idx]) entrances.push_back(e);
+
+    for (Entrance e : entrances) {
+        if (this->find_node(cluster, e.idx_a) >= 0) continue;
+        cluster.nodes.push_back(
+            {.idx = e.idx_a, .first_link = 0, .n_links = 0, .n_border_links = 0}
+        );
+    }
+
+    // -------------------------------------------------------------------
+    // Per node: its border steps (resolved by link_cluster()), then the
+    // intra-cluster paths to every other node it reaches
+    uint32_t first_id = cluster_idx * this->n_cluster_node_ids;
+    uint32_t n_nodes = cluster.nodes.size();
+    for (uint32_t i = 0; i < n_nodes; ++i) {
+        Node &node = cluster.nodes[i];
+        node.first_link = cluster.links.size();
+        for (Entrance e : entrances) {
+            if (e.idx_a != node.idx) continue;
+            Link link = {.idx = e.idx_b, .node_id = 0, .cost = this->get_cost(e.idx_b)};
+            cluster.links.push_back(link);
+        }
+        node.n_border_links = cluster.links.size() - node.first_link;
+
+        this->search_local(cluster.bounds, node.idx, no_idx, false);
+        for (uint32_t j = 0; j < n_nodes; ++j) {
+            uint32_t nb_idx = cluster.nodes[j].idx;
+            float cost = this->get_local_dist(cluster.bounds, nb_idx);
+            if (j == i || std::isinf(cost)) continue;
+            cluster.links.push_back(
+                {.idx = nb_idx, .node_id = first_id + j, .cost = cost}
+            );
+        }
+        node.n_links = cluster.links.size() - node.first_link;
+    }
+}
+
+void PathGraph::link_cluster(uint32_t cluster_idx) {
+    // Resolves the border link targets to node ids, must be redone whenever
+    // the neighbor cluster has been rebuilt and its nodes got reordered
+    Cluster &cluster = this->clusters[cluster_idx];
+    for (const Node &node : cluster.nodes) {
+        for (uint32_t i = 0; i < node.n_border_links; ++i) {
+            Link &link = cluster.links[node.first_link + i];
+            uint32_t nb_cluster_idx = this->get_cluster_idx(link.idx);
+            const Cluster &nb_cluster = this->clusters[nb_cluster_idx];
+            int32_t nb_node_idx = this->find_node(nb_cluster, link.idx);
+            link.node_id = nb_cluster_idx * this->n_cluster_node_ids + nb_node_idx;
+        }
+    }
+}
+
+void PathGraph::search_local(
+    const Bounds &bounds, uint32_t source_idx, uint32_t target_idx, bool is_reverse
+) {
+    uint32_t stride = bounds.n_cols + 2;
+    uint32_t n_local = (bounds.n_rows + 2) * stride;
+    this->local_costs.assign(n_local, INFINITY);
+    this->local_dists.assign(n_local, INFINITY);
+    this->local_parents.assign(n_local, no_idx);
+    for (uint32_t row = 0; row < bounds.n_rows; ++row) {
+        uint32_t idx = (bounds.row + row) * this->n_cols + bounds.col;
+        float *costs = &this->local_costs[(row + 1) * stride + 1];
+        for (uint32_t col = 0; col < bounds.n_cols; ++col) {
+            costs[col] = this->get_cost(idx + col);
+        }
+    }
+
+    int32_t offsets[8];
+    for (uint32_t dir = 0; dir < 8; ++dir) {
+        offsets[dir] = dir_rows[dir] * (int32_t)stride + dir_cols[dir];
+    }
+
+    uint32_t source = this->get_local_idx(bounds, source_idx);
+    uint32_t target = target_idx == no_idx ? no_idx
+                                           : this->get_local_idx(bounds, target_idx);
+    if (std::isinf(this->local_costs[source])) return;
+
+    // With the target known the search is A* towards it
+    auto get_heuristic = [&](uint32_t idx) -> float {
+        if (target == no_idx) return 0.0;
+        uint32_t row = bounds.row + idx / stride - 1;
+        uint32_t col = bounds.col + idx % stride - 1;
+        return this->get_heuristic(row * this->n_cols + col, target_idx);
+    };
+
+    auto cmp = is_heap_item_after;
+    auto &heap = this->local_heap;
+    heap.clear();
+    heap.push_back({get_heuristic(source), 0.0, source});
+    this->local_dists[source] = 0.0;
+
+    const float *costs = this->local_costs.data();
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto [f, dist, idx] = heap.back();
+        heap.pop_back();
+        if (idx == target) return;
+        if (dist > this->local_dists[idx]) continue;
+
+        for (uint32_t dir = 0; dir < 8; ++dir) {
+            uint32_t nb = idx + offsets[dir];
+            if (std::isinf(costs[nb])) continue;
+
+            // Diagonal step: both orthogonal cells must be passable
+            if (dir % 2 == 1) {
+                if (std::isinf(costs[idx + offsets[dir - 1]])) continue;
+                if (std::isinf(costs[idx + offsets[(dir + 1) % 8]])) continue;
+            }
+
+            // Reverse search walks the steps backwards: the cost is paid
+            // for entering the current cell, not the neighbor
+            float cost = is_reverse ? costs[idx] : costs[nb];
+            float nb_dist = dist + cost * dir_lens[dir];
+            if (nb_dist < this->local_dists[nb]) {
+                this->local_dists[nb] = nb_dist;
+                this->local_parents[nb] = idx;
+                heap.push_back({nb_dist + get_heuristic(nb), nb_dist, nb});
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+        }
+    }
+}
+
+void PathGraph::append_local_path(
+    const Bounds &bounds, uint32_t idx, std::vector<uint32_t> &path
+) {
+    // Walks the parents of the last forward search back to its source,
+    // which is not appended
+    uint32_t stride = bounds.n_cols + 2;
+    uint32_t n_path = path.size();
+    uint32_t local_idx = this->get_local_idx(bounds, idx);
+    while (this->local_parents[local_idx] != no_idx) {
+        uint32_t row = bounds.row + local_idx / stride - 1;
+        uint32_t col = bounds.col + local_idx % stride - 1;
+        path.push_back(row * this->n_cols + col);
+        local_idx = this->local_parents[local_idx];
+    }
+    std::reverse(path.begin() + n_path, path.end());
+}
+
+// -----------------------------------------------------------------------
+// graph
+void PathGraph::set_terrain(uint32_t idx, Terrain terrain) {
+    if (idx >= this->terrain.size() || this->terrain[idx] == terrain) return;
+    this->terrain[idx] = terrain;
+
+    uint32_t cluster_idx = this->get_cluster_idx(idx);
+    const Bounds &bounds = this->clusters[cluster_idx].bounds;
+    uint32_t row = idx / this->n_cols;
+    uint32_t col = idx % this->n_cols;
+    this->mark_cluster(cluster_idx);
+
+    // Cells on the cluster edges also change the entrances of the borders
+    if (row == bounds.row && bounds.row > 0) {
+        this->mark_h_border(cluster_idx - this->n_cluster_cols);
+    }
+    if (row == bounds.row + bounds.n_rows - 1) this->mark_h_border(cluster_idx);
+    if (col == bounds.col && bounds.col > 0) this->mark_v_border(cluster_idx - 1);
+    if (col == bounds.col + bounds.n_cols - 1) this->mark_v_border(cluster_idx);
+}
+
+void PathGraph::update() {
+    for (uint32_t cluster_idx : this->dirty_h_border_idxs) {
+        this->build_h_border(cluster_idx);
+        this->is_h_border_dirty[cluster_idx] = 0;
+    }
+    for (uint32_t cluster_idx : this->dirty_v_border_idxs) {
+        this->build_v_border(cluster_idx);
+        this->is_v_border_dirty[cluster_idx] = 0;
+    }
+    for (uint32_t cluster_idx : this->dirty_cluster_idxs) {
+        this->build_cluster(cluster_idx);
+        this->is_cluster_dirty[cluster_idx] = 0;
+    }
+    for (uint32_t cluster_idx : this->dirty_cluster_idxs) {
+        uint32_t cluster_row = cluster_idx / this->n_cluster_cols;
+        uint32_t cluster_col = cluster_idx % this->n_cluster_cols;
+        this->link_cluster(cluster_idx);
+        if (cluster_row > 0) this->link_cluster(cluster_idx - this->n_cluster_cols);
+        if (cluster_col > 0) this->link_cluster(cluster_idx - 1);
+        if (cluster_row + 1 < this->n_cluster_rows) {
+            this->link_cluster(cluster_idx + this->n_cluster_cols);
+        }
+        if (cluster_col + 1 < this->n_cluster_cols) this->link_cluster(cluster_idx + 1);
+    }
+
+    this->dirty_h_border_idxs.clear();
+    this->dirty_v_border_idxs.clear();
+    this->dirty_cluster_idxs.clear();
+}
+
+std::vector<uint32_t> PathGraph::find_path(uint32_t start_idx, uint32_t goal_idx) {
+    uint32_t n_cells = this->terrain.size();
+    if (start_idx >= n_cells || goal_idx >= n_cells) return {};
+    if (std::isinf(this->get_cost(start_idx))) return {};
+    if (std::isinf(this->get_cost(goal_idx))) return {};
+    if (start_idx == goal_idx) return {start_idx};
+
+    std::vector<uint32_t> path = {start_idx};
+
+    // -------------------------------------------------------------------
+    // Close goals are searched directly in a window around both ends: the
+    // entrances alone would route them through the nearest border openings
+    uint32_t start_row = start_idx / this->n_cols;
+    uint32_t start_col = start_idx % this->n_cols;
+    uint32_t goal_row = goal_idx / this->n_cols;
+    uint32_t goal_col = goal_idx % this->n_cols;
+    uint32_t d_row = std::max(start_row, goal_row) - std::min(start_row, goal_row);
+    uint32_t d_col = std::max(start_col, goal_col) - std::min(start_col, goal_col);
+    if (std::max(d_row, d_col) <= this->cluster_size) {
+        uint32_t margin = this->cluster_size / 2;
+        uint32_t row = std::min(start_row, goal_row);
+        uint32_t col = std::min(start_col, goal_col);
+        Bounds window;
+        window.row = row > margin ? row - margin : 0;
+        window.col = col > margin ? col - margin : 0;
+        window.n_rows = std::min(this->n_rows, row + d_row + margin + 1) - window.row;
+        window.n_cols = std::min(this->n_cols, col + d_col + margin + 1) - window.col;
+
+        this->search_local(window, start_idx, goal_idx, false);
+        if (!std::isinf(this->get_local_dist(window, goal_idx))) {
+            this->append_local_path(window, goal_idx, path);
+            return path;
+        }
+    }
+
+    this->update();
+
+    // -------------------------------------------------------------------
+    // Temporary edges: start -> nodes of its cluster, nodes of the goal
+    // cluster -> goal and start -> goal if they share the cluster
+    uint32_t start_cluster_idx = this->get_cluster_idx(start_idx);
+    uint32_t goal_cluster_idx = this->get_cluster_idx(goal_idx);
+    const Cluster &start_cluster = this->clusters[start_cluster_idx];
+    const Cluster &goal_cluster = this->clusters[goal_cluster_idx];
+
+    this->search_local(start_cluster.bounds, start_idx, no_idx, false);
+    std::vector<float> start_costs;
+    for (const Node &node : start_cluster.nodes) {
+        start_costs.push_back(this->get_local_dist(start_cluster.bounds, node.idx));
+    }
+    float direct_cost = INFINITY;
+    if (start_cluster_idx == goal_cluster_idx) {
+        direct_cost = this->get_local_dist(start_cluster.bounds, goal_idx);
+    }
+
+    this->search_local(goal_cluster.bounds, goal_idx, no_idx, true);
+    std::vector<float> goal_costs;
+    for (const Node &node : goal_cluster.nodes) {
+        goal_costs.push_back(this->get_local_dist(goal_cluster.bounds, node.idx));
+    }
+
+    // -------------------------------------------------------------------
+    // A* over the abstract graph
+    this->stamp += 1;
+    if (this->stamp == 0) {
+        for (SearchNode &node : this->search_nodes) node.stamp = 0;
+        this->stamp = 1;
+    }
+
+    uint32_t start_id = this->search_nodes.size() - 2;
+    uint32_t goal_id = this->search_nodes.size() - 1;
+
+    auto cmp = is_heap_item_after;
+    std::vector<HeapItem> heap;
+    auto relax = [&](uint32_t id, uint32_t nb_id, uint32_t nb_idx, float dist) {
+        if (std::isinf(dist)) return;
+
+        SearchNode &nb = this->search_nodes[nb_id];
+        if (nb.stamp != this->stamp) {
+            nb.heuristic = this->get_heuristic(nb_idx, goal_idx);
+            nb.stamp = this->stamp;
+        } else if (nb.dist <= dist) {
+            return;
+        }
+
+        nb.dist = dist;
+        nb.parent_id = id;
+        heap.push_back({dist + nb.heuristic, dist, nb_id});
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    };
+
+    this->search_nodes[start_id] = {
+        .dist = 0.0, .heuristic = 0.0, .parent_id = no_idx, .stamp = this->stamp};
+    heap.push_back({0.0, 0.0, start_id});
+
+    bool is_found = false;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto [f, dist, id] = heap.back();
+        heap.pop_back();
+        if (dist > this->search_nodes[id].dist) continue;
+        if (id == goal_id) {
+            is_found = true;
+            break;
+        }
+
+        if (id == start_id) {
+            uint32_t first_id = start_cluster_idx * this->n_cluster_node_ids;
+            for (uint32_t i = 0; i < start_cluster.nodes.size(); ++i) {
+                uint32_t nb_idx = start_cluster.nodes[i].idx;
+                relax(id, first_id + i, nb_idx, start_costs[i]);
+            }
+            relax(id, goal_id, goal_idx, direct_cost);
+            continue;
+        }
+
+        uint32_t cluster_idx = id / this->n_cluster_node_ids;
+        uint32_t node_idx = id % this->n_cluster_node_ids;
+        const Cluster &cluster = this->clusters[cluster_idx];
+        const Node &node = cluster.nodes[node_idx];
+        const Link *links = cluster.links.data() + node.first_link;
+        for (uint32_t i = 0; i < node.n_links; ++i) {
+            relax(id, links[i].node_id, links[i].idx, dist + links[i].cost);
+        }
+        if (cluster_idx == goal_cluster_idx) {
+            relax(id, goal_id, goal_idx, dist + goal_costs[node_idx]);
+        }
+    }
+
+    if (!is_found) return {};
+
+    // -------------------------------------------------------------------
+    // Refine: consecutive abstract nodes are either linked across a border
+    // or connected inside one cluster, which is searched again for the cells
+    std::vector<uint32_t> waypoints;
+    for (uint32_t id = goal_id; id != start_id; id = this->search_nodes[id].parent_id) {
+        if (id == goal_id) {
+            waypoints.push_back(goal_idx);
+        } else {
+            const Cluster &cluster = this->clusters[id / this->n_cluster_node_ids];
+            waypoints.push_back(cluster.nodes[id % this->n_cluster_node_ids].idx);
+        }
+    }
+    waypoints.push_back(start_idx);
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    for (uint32_t i = 1; i < waypoints.size(); ++i) {
+        uint32_t from_idx = waypoints[i - 1];
+        uint32_t to_idx = waypoints[i];
+        uint32_t cluster_idx = this->get_cluster_idx(from_idx);
+        if (cluster_idx != this->get_cluster_idx(to_idx)) {
+            path.push_back(to_idx);
+            continue;
+        }
+
+        const Bounds &bounds = this->clusters[cluster_idx].bounds;
+        this->search_local(bounds, from_idx, to_idx, false);
+        this->append_local_path(bounds, to_idx, path);
+    }
+
+    return path;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "terrain.hpp"
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Hierarchical path graph (HPA*) over an 8-connected grid. The grid is
+// split into square clusters, the passable runs along the cluster borders
+// get entrance nodes and every cluster caches the path costs between its
+// own entrances. Queries search this small abstract graph and then refine
+// the route inside the visited clusters only, so the routes are near
+// optimal, not exactly shortest.
+//
+// Terrain changes only dirty the touched cluster (and the borders the cell
+// lies on): those are rebuilt on the next update() or query.
+//
+// Cells are addressed by the row-major index row * n_cols + col.
+class PathGraph {
+private:
+    // A* open list item: estimated total cost, cost so far and the node
+    using HeapItem = std::tuple<float, float, uint32_t>;
+
+    // Pair of cells facing each other across a border, idx_a is in the
+    // top (left) cluster and idx_b is in the bottom (right) one
+    struct Entrance {
+        uint32_t idx_a;
+        uint32_t idx_b;
+    };
+
+    // Edge of the abstract graph: a step across a border to the node of the
+    // neighbor cluster, or a cached path inside the cluster to another of
+    // its nodes
+    struct Link {
+        uint32_t idx;
+        uint32_t node_id;
+        float cost;
+    };
+
+    // Links are the range [first_link, first_link + n_links) of the
+    // cluster's, the border steps first
+    struct Node {
+        uint32_t idx;
+        uint32_t first_link;
+        uint32_t n_links;
+        uint32_t n_border_links;
+    };
+
+    // Sub-grid the local searches are restricted to
+    struct Bounds {
+        uint32_t row;
+        uint32_t col;
+        uint32_t n_rows;
+        uint32_t n_cols;
+    };
+
+    // The links of all the nodes are kept together, so the abstract search
+    // reads a cluster from two blocks. Only the node pairs connected inside
+    // the cluster are linked
+    struct Cluster {
+        Bounds bounds;
+        std::vector<Node> nodes;
+        std::vector<Link> links;
+    };
+
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t cluster_size;
+    uint32_t n_cluster_rows;
+    uint32_t n_cluster_cols;
+
+    // Every cluster owns a fixed range of node ids, a border of n cells
+    // can't have more than n entrances
+    uint32_t n_cluster_node_ids;
+
+    // Cost of entering a door cell, negative - doors are impassable
+    float door_cost;
+
+    std::vector<Terrain> terrain;
+    std::vector<Cluster> clusters;
+
+    // Border between the cluster and its bottom (horizontal) or right
+    // (vertical) neighbor, indexed as the cluster
+    std::vector<std::vector<Entrance>> h_borders;
+    std::vector<std::vector<Entrance>> v_borders;
+
+    // Scratch buffer of build_cluster(): the entrances as (node cell,
+    // cell across the border) pairs
+    std::vector<Entrance> cluster_entrances;
+
+    std::vector<uint32_t> dirty_cluster_idxs;
+    std::vector<uint32_t> dirty_h_border_idxs;
+    std::vector<uint32_t> dirty_v_border_idxs;
+    std::vector<uint8_t> is_cluster_dirty;
+    std::vector<uint8_t> is_h_border_dirty;
+    std::vector<uint8_t> is_v_border_dirty;
+
+    // Scratch buffers of the local search. The bounds are copied with a
+    // ring of impassable cells around them, so steps need no bound checks
+    std::vector<float> local_costs;
+    std::vector<float> local_dists;
+    std::vector<uint32_t> local_parents;
+    std::vector<HeapItem> local_heap;
+
+    // Scratch buffer of the abstract search indexed by the node id (the
+    // last two are the query start and goal), reset lazily by the stamp
+    struct SearchNode {
+        float dist;
+        float heuristic;
+        uint32_t parent_id;
+        uint32_t stamp;
+    };
+    std::vector<SearchNode> search_nodes;
+    uint32_t stamp = 0;
+
+    float get_cost(uint32_t idx);
+    float get_heuristic(uint32_t idx, uint32_t goal_idx);
+
+    uint32_t get_cluster_idx(uint32_t idx);
+    uint32_t get_local_idx(const Bounds &bounds, uint32_t idx);
+    int32_t find_node(const Cluster &cluster, uint32_t idx);
+
+    void mark_cluster(uint32_t cluster_idx);
+    void mark_h_border(uint32_t cluster_idx);
+    void mark_v_border(uint32_t cluster_idx);
+
+    void add_entrances(
+        std::vector<Entrance> &entrances,
+        uint32_t idx_a,
+        uint32_t along_step,
+        uint32_t across_step,
+        uint32_t n
+    );
+    void build_h_border(uint32_t cluster_idx);
+    void build_v_border(uint32_t cluster_idx);
+    void build_cluster(uint32_t cluster_idx);
+    void link_cluster(uint32_t cluster_idx);
+
+    // Dijkstra restricted to the bounds, stops early once the target is
+    // settled. Reverse search gives the costs from every cell to the source
+    // instead of from the source
+    void search_local(
+        const Bounds &bounds, uint32_t source_idx, uint32_t target_idx, bool is_reverse
+    );
+    float get_local_dist(const Bounds &bounds, uint32_t idx);
+    void append_local_path(
+        const Bounds &bounds, uint32_t idx, std::vector<uint32_t> &path
+    );
+
+public:
+    PathGraph(uint32_t n_rows, uint32_t n_cols, uint32_t cluster_size, float door_cost);
+
+    void set_terrain(uint32_t idx, Terrain terrain);
+
+    // Rebuilds the dirty borders and clusters
+    void update();
+
+    // Cells of the route from start to goal (both included), empty if the
+    // goal is unreachable
+    std::vector<uint32_t> find_path(uint32_t start_idx, uint32_t goal_idx);
+};
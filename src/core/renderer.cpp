@@ -140,6 +140,17 @@ void Renderer::draw_grid(Rectangle bound_rect, float step, Color color) {
     }
 }
 
+void Renderer::draw_light(
+    Vector2 position, const std::vector<Vector2> &polygon, Color color
+) {
+    BeginBlendMode(BLEND_ADDITIVE);
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        Vector2 next = polygon[(i + 1) % polygon.size()];
+        DrawTriangle(position, polygon[i], next, color);
+    }
+    EndBlendMode();
+}
+
 void Renderer::begin_drawing() {
     BeginDrawing();
     ClearBackground(BLACK);
@@ -153,14 +164,16 @@ void Renderer::end_drawing() {
 }
 
 void Renderer::set_camera(Vector2 position, float view_width) {
+    set_camera(position, view_width, (float)screen_width / screen_height);
+}
+
+void Renderer::set_camera(Vector2 position, float view_width, float aspect) {
     rlDrawRenderBatchActive();
 
     int position_loc = GetShaderLocation(shader, "camera.position");
     int view_width_loc = GetShaderLocation(shader, "camera.view_width");
     int aspect_loc = GetShaderLocation(shader, "camera.aspect");
 
-    float aspect = (float)screen_width / screen_height;
-
     SetShaderValue(shader, position_loc, &position, SHADER_UNIFORM_VEC2);
     SetShaderValue(shader, view_width_loc, &view_width, SHADER_UNIFORM_FLOAT);
     SetShaderValue(shader, aspect_loc, &aspect, SHADER_UNIFORM_FLOAT);
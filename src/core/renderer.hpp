@@ -3,6 +3,7 @@
 #include "geometry.hpp"
 #include "raylib.h"
 #include "sprite.hpp"
+#include <vector>
 
 enum class RenderableType {
     CIRCLE, 
@@ -65,6 +66,13 @@ class Renderer {
 
         void draw_grid(Rectangle bound_rect, float step, Color color = GRAY);
 
+        // Additively blended triangle fan around the light position
+        void draw_light(
+            Vector2 position, const std::vector<Vector2> &polygon, Color color
+        );
+
+        // The aspect is the screen's unless given, e.g. for render textures
         void set_camera(Vector2 position, float view_width);
+        void set_camera(Vector2 position, float view_width, float aspect);
         void set_screen_camera();
 };
@@ -1,8 +1,10 @@
 #include "resources.hpp"
 
+#include "animation.hpp"
 #include "sprite.hpp"
 
 Resources::Resources()
     : sprite_sheet(SpriteSheet(
         "resources/sprites/sheet_16_16.png", "resources/sprites/sheet_16_16.json"
-    )) {}
+    ))
+    , animation_table(AnimationTable("resources/sprites/sheet_16_16.json")) {}
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "animation.hpp"
 #include "raylib.h"
 #include "sprite.hpp"
 
 class Resources {
     public:
         SpriteSheet sprite_sheet;
+        AnimationTable animation_table;
 
         Resources(const Resources&) = delete;
         Resources& operator=(const Resources&) = delete;
@@ -0,0 +1,295 @@
+#include "room_graph.hpp"
+
+#include "terrain.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+static constexpr uint32_t no_slot = UINT32_MAX;
+
+RoomGraph::RoomGraph(uint32_t n_rows, uint32_t n_cols)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , terrain(n_rows * n_cols, Terrain::FLOOR)
+    , labels(n_rows * n_cols, 0)
+    , parents{0}
+    , sizes{n_rows * n_cols}
+    , n_edge_cells{0}
+    , door_slots(n_rows * n_cols, no_slot)
+    , visit_stamps(n_rows * n_cols, 0)
+    , visit_owners(n_rows * n_cols, 0) {
+
+    // The whole grid starts as one open room
+    for (uint32_t idx = 0; idx < n_rows * n_cols; ++idx) {
+        this->n_edge_cells[0] += this->is_edge(idx);
+    }
+}
+
+bool RoomGraph::is_floor(uint32_t idx) const {
+    return this->terrain[idx] == Terrain::FLOOR;
+}
+
+bool RoomGraph::is_edge(uint32_t idx) const {
+    uint32_t row = idx / this->n_cols;
+    uint32_t col = idx % this->n_cols;
+    return row == 0 || row == this->n_rows - 1 || col == 0 || col == this->n_cols - 1;
+}
+
+uint32_t RoomGraph::get_neighbors(uint32_t idx, uint32_t nb_idxs[4]) const {
+    uint32_t row = idx / this->n_cols;
+    uint32_t col = idx % this->n_cols;
+    uint32_t n = 0;
+    if (col > 0) nb_idxs[n++] = idx - 1;
+    if (row > 0) nb_idxs[n++] = idx - this->n_cols;
+    if (col + 1 < this->n_cols) nb_idxs[n++] = idx + 1;
+    if (row + 1 < this->n_rows) nb_idxs[n++] = idx + this->n_cols;
+    return n;
+}
+
+// -----------------------------------------------------------------------
+// union-find
+uint32_t RoomGraph::find(uint32_t id) {
+    while (this->parents[id] != id) {
+        this->parents[id] = this->parents[this->parents[id]];
+        id = this->parents[id];
+    }
+    return id;
+}
+
+uint32_t RoomGraph::create_room() {
+    uint32_t id = this->parents.size();
+    this->parents.push_back(id);
+    this->sizes.push_back(0);
+    this->n_edge_cells.push_back(0);
+    this->n_rooms += 1;
+    return id;
+}
+
+uint32_t RoomGraph::unite(uint32_t a, uint32_t b) {
+    a = this->find(a);
+    b = this->find(b);
+    if (a == b) return a;
+
+    if (this->sizes[a] < this->sizes[b]) std::swap(a, b);
+    this->parents[b] = a;
+    this->sizes[a] += this->sizes[b];
+    this->n_edge_cells[a] += this->n_edge_cells[b];
+    this->n_rooms -= 1;
+    return a;
+}
+
+// -----------------------------------------------------------------------
+// terrain changes
+void RoomGraph::open_cell(uint32_t idx) {
+    uint32_t nb_idxs[4];
+    uint32_t n_nbs = this->get_neighbors(idx, nb_idxs);
+
+    uint32_t room = no_room;
+    for (uint32_t i = 0; i < n_nbs; ++i) {
+        if (!this->is_floor(nb_idxs[i])) continue;
+        uint32_t nb_room = this->labels[nb_idxs[i]];
+        room = room == no_room ? this->find(nb_room) : this->unite(room, nb_room);
+    }
+    if (room == no_room) room = this->create_room();
+
+    this->labels[idx] = room;
+    this->sizes[room] += 1;
+    this->n_edge_cells[room] += this->is_edge(idx);
+}
+
+void RoomGraph::block_cell(uint32_t idx) {
+    uint32_t room = this->find(this->labels[idx]);
+    this->labels[idx] = no_room;
+    this->sizes[room] -= 1;
+    this->n_edge_cells[room] -= this->is_edge(idx);
+    if (this->sizes[room] == 0) {
+        this->n_rooms -= 1;
+        return;
+    }
+
+    uint32_t nb_idxs[4];
+    uint32_t n_nbs = this->get_neighbors(idx, nb_idxs);
+    uint32_t n_starts = 0;
+    for (uint32_t i = 0; i < n_nbs; ++i) {
+        if (this->is_floor(nb_idxs[i])) nb_idxs[n_starts++] = nb_idxs[i];
+    }
+    if (n_starts <= 1) return;
+
+    // -------------------------------------------------------------------
+    // Flood from every floor neighbor one cell at a time. Floods which
+    // meet join a group, a group which runs out of cells while others are
+    // still going is a separate room now. The last group keeps the room
+    this->stamp += 1;
+    if (this->stamp == 0) {
+        std::fill(this->visit_stamps.begin(), this->visit_stamps.end(), 0);
+        this->stamp = 1;
+    }
+
+    uint32_t heads[4];
+    uint32_t groups[4];
+    uint32_t n_active[4];
+    for (uint32_t i = 0; i < n_starts; ++i) {
+        this->split_queues[i].assign(1, nb_idxs[i]);
+        this->visit_stamps[nb_idxs[i]] = this->stamp;
+        this->visit_owners[nb_idxs[i]] = i;
+        heads[i] = 0;
+        groups[i] = i;
+        n_active[i] = 1;
+    }
+
+    auto get_group = [&](uint32_t i) {
+        while (groups[i] != i) i = groups[i];
+        return i;
+    };
+
+    auto split_group = [&](uint32_t group) {
+        uint32_t new_room = this->create_room();
+        for (uint32_t i = 0; i < n_starts; ++i) {
+            if (get_group(i) != group) continue;
+            for (uint32_t cell_idx : this->split_queues[i]) {
+                this->labels[cell_idx] = new_room;
+                this->sizes[new_room] += 1;
+                this->n_edge_cells[new_room] += this->is_edge(cell_idx);
+            }
+        }
+        this->sizes[room] -= this->sizes[new_room];
+        this->n_edge_cells[room] -= this->n_edge_cells[new_room];
+    };
+
+    uint32_t n_open_groups = n_starts;
+    while (n_open_groups > 1) {
+        for (uint32_t i = 0; i < n_starts && n_open_groups > 1; ++i) {
+            std::vector<uint32_t> &queue = this->split_queues[i];
+            if (heads[i] == queue.size()) continue;
+
+            uint32_t cell_idx = queue[heads[i]++];
+            uint32_t cell_nb_idxs[4];
+            uint32_t n_cell_nbs = this->get_neighbors(cell_idx, cell_nb_idxs);
+            for (uint32_t j = 0; j < n_cell_nbs; ++j) {
+                uint32_t nb_idx = cell_nb_idxs[j];
+                if (!this->is_floor(nb_idx)) continue;
+
+                if (this->visit_stamps[nb_idx] != this->stamp) {
+                    this->visit_stamps[nb_idx] = this->stamp;
+                    this->visit_owners[nb_idx] = i;
+                    queue.push_back(nb_idx);
+                    continue;
+                }
+
+                uint32_t group = get_group(i);
+                uint32_t nb_group = get_group(this->visit_owners[nb_idx]);
+                if (group != nb_group) {
+                    groups[nb_group] = group;
+                    n_active[group] += n_active[nb_group];
+                    n_open_groups -= 1;
+                }
+            }
+
+            if (heads[i] < queue.size()) continue;
+            uint32_t group = get_group(i);
+            n_active[group] -= 1;
+            if (n_active[group] > 0) continue;
+
+            if (n_open_groups > 1) split_group(group);
+            n_open_groups -= 1;
+        }
+    }
+}
+
+void RoomGraph::compact() {
+    // Splits keep adding room ids, renumber the live rooms densely
+    std::vector<uint32_t> new_ids(this->parents.size(), no_room);
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> n_edge_cells;
+    for (uint32_t &label : this->labels) {
+        if (label == no_room) continue;
+
+        uint32_t room = this->find(label);
+        if (new_ids[room] == no_room) {
+            new_ids[room] = parents.size();
+            parents.push_back(parents.size());
+            sizes.push_back(this->sizes[room]);
+            n_edge_cells.push_back(this->n_edge_cells[room]);
+        }
+        label = new_ids[room];
+    }
+
+    this->parents = std::move(parents);
+    this->sizes = std::move(sizes);
+    this->n_edge_cells = std::move(n_edge_cells);
+}
+
+void RoomGraph::set_terrain(uint32_t idx, Terrain terrain) {
+    if (idx >= this->terrain.size() || this->terrain[idx] == terrain) return;
+
+    if (this->terrain[idx] == Terrain::DOOR) {
+        uint32_t slot = this->door_slots[idx];
+        uint32_t last_idx = this->door_idxs.back();
+        this->door_idxs[slot] = last_idx;
+        this->door_slots[last_idx] = slot;
+        this->door_idxs.pop_back();
+        this->door_slots[idx] = no_slot;
+    }
+    if (terrain == Terrain::DOOR) {
+        this->door_slots[idx] = this->door_idxs.size();
+        this->door_idxs.push_back(idx);
+    }
+
+    bool was_floor = this->is_floor(idx);
+    this->terrain[idx] = terrain;
+    if (was_floor && terrain != Terrain::FLOOR) this->block_cell(idx);
+    else if (!was_floor && terrain == Terrain::FLOOR) this->open_cell(idx);
+
+    if (this->parents.size() >= 2 * this->labels.size()) this->compact();
+}
+
+// -----------------------------------------------------------------------
+// queries
+uint32_t RoomGraph::room_of(uint32_t idx) const {
+    if (idx >= this->labels.size() || this->labels[idx] == no_room) return no_room;
+
+    // Union by size keeps the chains short, the mutating finds halve them
+    uint32_t id = this->labels[idx];
+    while (this->parents[id] != id) id = this->parents[id];
+    return id;
+}
+
+uint32_t RoomGraph::get_room_size(uint32_t room) const {
+    return room < this->sizes.size() ? this->sizes[room] : 0;
+}
+
+bool RoomGraph::is_enclosed(uint32_t room) const {
+    return room < this->n_edge_cells.size() && this->n_edge_cells[room] == 0;
+}
+
+uint32_t RoomGraph::get_n_rooms() const {
+    return this->n_rooms;
+}
+
+void RoomGraph::get_links(std::vector<Link> &links) const {
+    for (uint32_t door_idx : this->door_idxs) {
+        uint32_t nb_idxs[4];
+        uint32_t n_nbs = this->get_neighbors(door_idx, nb_idxs);
+
+        uint32_t rooms[4];
+        uint32_t n_rooms = 0;
+        for (uint32_t i = 0; i < n_nbs; ++i) {
+            uint32_t room = this->room_of(nb_idxs[i]);
+            if (room == no_room) continue;
+            if (std::find(rooms, rooms + n_rooms, room) != rooms + n_rooms) continue;
+            rooms[n_rooms++] = room;
+        }
+
+        for (uint32_t a = 0; a < n_rooms; ++a) {
+            for (uint32_t b = a + 1; b < n_rooms; ++b) {
+                links.push_back(
+                    {.door_idx = door_idx,
+                     .room_a = std::min(rooms[a], rooms[b]),
+                     .room_b = std::max(rooms[a], rooms[b])}
+                );
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "terrain.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Rooms are the 4-connected floor regions of the grid, walls and doors
+// separate them and the doors are the links between the rooms.
+//
+// Placements update the rooms incrementally: opening a cell unions the
+// rooms around it, blocking one floods out from its neighbors in lockstep
+// until they meet again, so a split only costs the size of the smaller
+// part. Room ids are valid until the next terrain change.
+//
+// Cells are addressed by the row-major index row * n_cols + col.
+class RoomGraph {
+public:
+    static constexpr uint32_t no_room = UINT32_MAX;
+
+    struct Link {
+        uint32_t door_idx;
+        uint32_t room_a;
+        uint32_t room_b;
+    };
+
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+
+    std::vector<Terrain> terrain;
+
+    // Room id of every floor cell, resolved to the room by the union-find
+    // over the ids
+    std::vector<uint32_t> labels;
+    std::vector<uint32_t> parents;
+
+    // Number of cells and of the map edge cells, valid for the roots only
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> n_edge_cells;
+    uint32_t n_rooms = 1;
+
+    std::vector<uint32_t> door_idxs;
+    std::vector<uint32_t> door_slots;
+
+    // Scratch buffers of the split search, one flood per blocked cell
+    // neighbor. Visits are reset lazily by the stamp
+    std::array<std::vector<uint32_t>, 4> split_queues;
+    std::vector<uint32_t> visit_stamps;
+    std::vector<uint8_t> visit_owners;
+    uint32_t stamp = 0;
+
+    bool is_floor(uint32_t idx) const;
+    bool is_edge(uint32_t idx) const;
+    uint32_t get_neighbors(uint32_t idx, uint32_t nb_idxs[4]) const;
+
+    uint32_t find(uint32_t id);
+    uint32_t create_room();
+    uint32_t unite(uint32_t a, uint32_t b);
+
+    void open_cell(uint32_t idx);
+    void block_cell(uint32_t idx);
+    void compact();
+
+public:
+    RoomGraph(uint32_t n_rows, uint32_t n_cols);
+
+    void set_terrain(uint32_t idx, Terrain terrain);
+
+    // Room of the floor cell, no_room for walls and doors
+    uint32_t room_of(uint32_t idx) const;
+    uint32_t get_room_size(uint32_t room) const;
+
+    // Enclosed rooms don't reach the map edge
+    bool is_enclosed(uint32_t room) const;
+    uint32_t get_n_rooms() const;
+
+    // Appends a link for every pair of different rooms a door connects
+    void get_links(std::vector<Link> &links) const;
+};
@@ -0,0 +1,62 @@
+#include "scheduler.hpp"
+
+#include "entt/entity/organizer.hpp"
+#include "entt/entity/registry.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+Scheduler::Scheduler() = default;
+
+void Scheduler::run(entt::registry &registry, ThreadPool &pool) {
+    if (this->graph.empty()) {
+        this->graph = this->organizer.graph();
+        this->n_parents.assign(this->graph.size(), 0);
+        this->timings.clear();
+        for (auto &vertex : this->graph) {
+            this->timings.push_back({.name = vertex.name(), .ns = 0});
+            vertex.prepare(registry);
+            for (size_t child : vertex.children()) ++this->n_parents[child];
+        }
+    }
+
+    uint32_t n_vertices = this->graph.size();
+    if (n_vertices == 0) return;
+
+    auto n_waiting = std::make_unique<std::atomic<uint32_t>[]>(n_vertices);
+    for (uint32_t i = 0; i < n_vertices; ++i) n_waiting[i] = this->n_parents[i];
+
+    // Systems are jobs of the run's fence, each one submits the children it
+    // was the last parent of. The calling thread runs systems too until
+    // they're all done. A system that throws doesn't submit its children,
+    // the rest of the run finishes and the wait rethrows on the caller
+    JobFence fence;
+    std::function<void(size_t)> run_vertex = [&](size_t idx) {
+        auto &vertex = this->graph[idx];
+        auto start = std::chrono::steady_clock::now();
+        vertex.callback()(vertex.data(), registry);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        this->timings[idx].ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+        for (size_t child : vertex.children()) {
+            if (n_waiting[child].fetch_sub(1) == 1) {
+                pool.submit(fence, [&run_vertex, child] { run_vertex(child); });
+            }
+        }
+    };
+
+    for (size_t idx = 0; idx < n_vertices; ++idx) {
+        if (this->graph[idx].top_level()) {
+            pool.submit(fence, [&run_vertex, idx] { run_vertex(idx); });
+        }
+    }
+
+    pool.wait(fence);
+}
+
+std::vector<SystemTiming> Scheduler::get_timings() {
+    return this->timings;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "entt/entity/organizer.hpp"
+#include "entt/entity/registry.hpp"
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <vector>
+
+struct SystemTiming {
+    const char *name;
+    uint64_t ns;
+};
+
+// Runs the systems as a dependency graph built from their declared
+// component access: `Req` types listed as const are read-only, others are
+// writable. Systems which don't conflict run concurrently on the pool,
+// conflicting ones run in the order they were added.
+class Scheduler {
+private:
+    entt::organizer organizer;
+    std::vector<entt::organizer::vertex> graph;
+    std::vector<uint32_t> n_parents;
+    std::vector<SystemTiming> timings;
+
+public:
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    Scheduler();
+
+    template <auto System, typename... Req, typename Type>
+    void add_system(Type &instance, const char *name) {
+        this->organizer.emplace<System, Req...>(instance, name);
+        this->graph.clear();
+    }
+
+    // Rethrows the first exception of the systems on the calling thread
+    void run(entt::registry &registry, ThreadPool &pool);
+
+    // Wall time of each system during the last run
+    std::vector<SystemTiming> get_timings();
+};
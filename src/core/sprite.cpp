@@ -1,28 +1,25 @@
 #include "sprite.hpp"
 
 #include "json.hpp"
+#include "json_utils.hpp"
 #include "raylib.h"
-#include <fstream>
 #include <string>
 
 using json = nlohmann::json;
 
-json load_json(std::string file_path) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + file_path);
-    }
-
-    auto data = json::parse(file);
-    file.close();
-    return data;
+// Mipmapped, so zoomed out views sample the sprites without aliasing. The
+// frames are extruded by a pixel, which keeps the first levels from
+// bleeding into each other
+static void set_mipmapped_filter(Texture &texture) {
+    GenTextureMipmaps(&texture);
+    SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
 }
 
 SpriteSheet::SpriteSheet(
     std::string image_file_path, uint32_t tile_width, uint32_t tile_height
 ) {
     this->texture = LoadTexture(image_file_path.c_str());
-    SetTextureFilter(this->texture, TEXTURE_FILTER_BILINEAR);
+    set_mipmapped_filter(this->texture);
 
     uint32_t n_rows = this->texture.height / tile_height;
     uint32_t n_cols = this->texture.width / tile_width;
@@ -41,7 +38,7 @@ SpriteSheet::SpriteSheet(
 
 SpriteSheet::SpriteSheet(std::string image_file_path, std::string ase_json_file_path) {
     this->texture = LoadTexture(image_file_path.c_str());
-    SetTextureFilter(this->texture, TEXTURE_FILTER_BILINEAR);
+    set_mipmapped_filter(this->texture);
 
     json ase = load_json(ase_json_file_path);
     for (auto frame : ase["frames"]) {
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-cell traversal class shared by the grid algorithms (navigation,
+// visibility, etc.), one byte per cell
+enum class Terrain : uint8_t {
+    FLOOR,
+    WALL,
+    DOOR,
+};
@@ -0,0 +1,254 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Pool and deque of the worker running on this thread, if any
+static thread_local ThreadPool *current_pool = nullptr;
+static thread_local uint32_t current_worker_idx = 0;
+
+bool JobFence::is_done() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->n_pending == 0;
+}
+
+ThreadPool::ThreadPool(uint32_t n_workers) {
+    for (uint32_t i = 0; i < n_workers + 1; ++i) {
+        this->deques.push_back(std::make_unique<Deque>());
+    }
+    for (uint32_t i = 0; i < n_workers; ++i) {
+        this->workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_mutex);
+        this->is_stopped = true;
+    }
+    this->job_cv.notify_all();
+
+    for (std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::get_n_workers() {
+    return this->workers.size();
+}
+
+void ThreadPool::worker_loop(uint32_t worker_idx) {
+    current_pool = this;
+    current_worker_idx = worker_idx;
+
+    while (true) {
+        Job job;
+        if (this->pop(&job)) {
+            this->run(job);
+            continue;
+        }
+
+        // Queued jobs are all run before the pool stops
+        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+        this->job_cv.wait(lock, [this] {
+            return this->is_stopped || this->n_queued.load() > 0;
+        });
+        if (this->is_stopped && this->n_queued.load() == 0) return;
+    }
+}
+
+uint32_t ThreadPool::get_deque_idx() {
+    if (current_pool == this) return current_worker_idx;
+    return this->workers.size();
+}
+
+void ThreadPool::push(Job job) {
+    Deque &deque = *this->deques[this->get_deque_idx()];
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.jobs.push_back(std::move(job));
+    }
+    this->n_queued.fetch_add(1);
+
+    // A worker between its last pop and the wait would miss the notify
+    // otherwise
+    { std::lock_guard<std::mutex> lock(this->sleep_mutex); }
+    this->job_cv.notify_one();
+    this->done_cv.notify_all();
+}
+
+bool ThreadPool::pop(Job *job) {
+    if (this->n_queued.load() == 0) return false;
+
+    uint32_t n_deques = this->deques.size();
+    uint32_t own_idx = this->get_deque_idx();
+    bool is_worker = own_idx < this->workers.size();
+    for (uint32_t i = 0; i < n_deques; ++i) {
+        Deque &deque = *this->deques[(own_idx + i) % n_deques];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.jobs.empty()) continue;
+
+        // Newest first from the own deque, oldest first from the others
+        if (i == 0 && is_worker) {
+            *job = std::move(deque.jobs.back());
+            deque.jobs.pop_back();
+        } else {
+            *job = std::move(deque.jobs.front());
+            deque.jobs.pop_front();
+        }
+        this->n_queued.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::run(Job &job) {
+    if (!job.fence) {
+        job.func();
+        return;
+    }
+
+    // The fence still has to complete, the waiter rethrows
+    std::exception_ptr error;
+    try {
+        job.func();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    bool is_fence_done;
+    {
+        std::lock_guard<std::mutex> lock(job.fence->mutex);
+        if (error && !job.fence->error) job.fence->error = error;
+        job.fence->n_pending -= 1;
+        is_fence_done = job.fence->n_pending == 0;
+    }
+
+    // The fence may be gone as soon as its waiter sees it done
+    if (is_fence_done) this->notify_done();
+}
+
+void ThreadPool::notify_done() {
+    // Same as push(): a waiter between its check and the wait would miss
+    // the notify otherwise
+    { std::lock_guard<std::mutex> lock(this->sleep_mutex); }
+    this->done_cv.notify_all();
+}
+
+void ThreadPool::help_until(const std::function<bool()> &is_done) {
+    while (!is_done()) {
+        Job job;
+        if (this->pop(&job)) {
+            this->run(job);
+            continue;
+        }
+
+        // The last jobs run elsewhere: sleep until one of them is done or
+        // more are queued
+        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+        this->done_cv.wait(lock, [&] {
+            return is_done() || this->n_queued.load() > 0;
+        });
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    Job job = {.func = std::move(task), .fence = nullptr};
+    if (this->workers.empty()) {
+        this->run(job);
+        return;
+    }
+
+    this->push(std::move(job));
+}
+
+void ThreadPool::submit(JobFence &fence, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(fence.mutex);
+        fence.n_pending += 1;
+    }
+
+    Job job = {.func = std::move(task), .fence = &fence};
+    if (this->workers.empty()) {
+        this->run(job);
+        return;
+    }
+
+    this->push(std::move(job));
+}
+
+void ThreadPool::wait(JobFence &fence) {
+    this->help_until([&fence] { return fence.is_done(); });
+
+    // Cleared, so the fence can be reused
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(fence.mutex);
+        std::swap(error, fence.error);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::parallel_for(
+    uint32_t n,
+    uint32_t min_chunk_size,
+    std::function<void(uint32_t begin, uint32_t end)> func
+) {
+    if (n == 0) return;
+
+    uint32_t n_threads = this->workers.size() + 1;
+    uint32_t chunk_size = std::max(min_chunk_size, (n + n_threads - 1) / n_threads);
+    uint32_t n_chunks = (n + chunk_size - 1) / chunk_size;
+    if (n_chunks == 1) {
+        func(0, n);
+        return;
+    }
+
+    // Helpers may start after the caller has already returned, so the
+    // shared state outlives this frame
+    struct State {
+        std::function<void(uint32_t, uint32_t)> func;
+        std::atomic<uint32_t> next_chunk{0};
+        std::atomic<uint32_t> n_done{0};
+
+        // First exception of func, rethrown on the caller
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->func = std::move(func);
+
+    auto run_chunks = [this, state, n, chunk_size, n_chunks]() {
+        uint32_t chunk;
+        while ((chunk = state->next_chunk.fetch_add(1)) < n_chunks) {
+            uint32_t begin = chunk * chunk_size;
+            uint32_t end = std::min(n, begin + chunk_size);
+            try {
+                state->func(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->error_mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            uint32_t n_done = state->n_done.fetch_add(1, std::memory_order_acq_rel) + 1;
+            if (n_done == n_chunks) this->notify_done();
+        }
+    };
+
+    for (uint32_t i = 1; i < std::min(n_chunks, n_threads); ++i) {
+        this->submit(run_chunks);
+    }
+    run_chunks();
+
+    this->help_until([&state, n_chunks] {
+        return state->n_done.load(std::memory_order_acquire) == n_chunks;
+    });
+
+    std::lock_guard<std::mutex> lock(state->error_mutex);
+    if (state->error) std::rethrow_exception(state->error);
+}
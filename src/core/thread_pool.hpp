@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Completion fence of a group of jobs: done once every job submitted with
+// it has finished. Jobs may submit children with the same fence, so a wait
+// covers the whole tree they spawn. A done fence can be reused, e.g. once
+// per frame.
+//
+// The first exception thrown by its jobs is kept and rethrown by the wait,
+// on the waiting thread.
+class JobFence {
+private:
+    friend class ThreadPool;
+
+    std::mutex mutex;
+    uint32_t n_pending = 0;
+    std::exception_ptr error;
+
+public:
+    JobFence(const JobFence &) = delete;
+    JobFence &operator=(const JobFence &) = delete;
+
+    JobFence() = default;
+
+    bool is_done();
+};
+
+// Fixed pool of workers with a job deque each. Workers push the jobs they
+// submit to their own deque and take them back newest first (the data is
+// still in the cache), idle workers steal the oldest jobs of the others.
+// Jobs submitted from outside the pool go to a shared deque.
+class ThreadPool {
+private:
+    struct Job {
+        std::function<void()> func;
+        JobFence *fence = nullptr;
+    };
+
+    struct Deque {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::thread> workers;
+
+    // One per worker, then the shared one
+    std::vector<std::unique_ptr<Deque>> deques;
+    std::atomic<uint32_t> n_queued{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable job_cv;
+    bool is_stopped = false;
+
+    // Threads in wait() and parallel_for() with nothing left to run sleep
+    // on it, woken when a job is queued or what they wait for is done
+    std::condition_variable done_cv;
+
+    void worker_loop(uint32_t worker_idx);
+    uint32_t get_deque_idx();
+    void push(Job job);
+    bool pop(Job *job);
+    void run(Job &job);
+    void notify_done();
+    void help_until(const std::function<bool()> &is_done);
+
+public:
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ThreadPool(uint32_t n_workers);
+    ~ThreadPool();
+
+    uint32_t get_n_workers();
+
+    // Without workers the jobs run inline, on the submitting thread. Nothing
+    // waits for a job without a fence, so it must not throw
+    void submit(std::function<void()> task);
+    void submit(JobFence &fence, std::function<void()> task);
+
+    // Runs the queued jobs on the calling thread until the fence is done,
+    // so it's safe to call from inside a job. Rethrows the first exception
+    // of the fence's jobs
+    void wait(JobFence &fence);
+
+    // Splits [0, n) into chunks of at least min_chunk_size items and runs
+    // them on the pool. The calling thread takes chunks too, so it's safe
+    // to call from inside a pool task. The first exception of func is
+    // rethrown once all the chunks are done.
+    void parallel_for(
+        uint32_t n,
+        uint32_t min_chunk_size,
+        std::function<void(uint32_t begin, uint32_t end)> func
+    );
+};
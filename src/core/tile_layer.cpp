@@ -0,0 +1,108 @@
+#include "tile_layer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+TileLayer::TileLayer(uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , chunk_size(chunk_size)
+    , n_chunk_rows((n_rows + chunk_size - 1) / chunk_size)
+    , n_chunk_cols((n_cols + chunk_size - 1) / chunk_size)
+    , chunks(this->n_chunk_rows * this->n_chunk_cols)
+    , chunk_n_tiles(this->n_chunk_rows * this->n_chunk_cols, 0)
+    , chunk_versions(this->n_chunk_rows * this->n_chunk_cols, 1)
+    , is_chunk_changed(this->n_chunk_rows * this->n_chunk_cols, 0) {}
+
+uint32_t TileLayer::get_n_rows() const {
+    return this->n_rows;
+}
+
+uint32_t TileLayer::get_n_cols() const {
+    return this->n_cols;
+}
+
+uint32_t TileLayer::get_chunk_size() const {
+    return this->chunk_size;
+}
+
+uint32_t TileLayer::get_n_chunk_rows() const {
+    return this->n_chunk_rows;
+}
+
+uint32_t TileLayer::get_n_chunk_cols() const {
+    return this->n_chunk_cols;
+}
+
+uint32_t TileLayer::get_chunk_idx(int32_t row, int32_t col) const {
+    return row / this->chunk_size * this->n_chunk_cols + col / this->chunk_size;
+}
+
+uint32_t TileLayer::get_tile_idx(int32_t row, int32_t col) const {
+    return row % this->chunk_size * this->chunk_size + col % this->chunk_size;
+}
+
+uint8_t TileLayer::get(int32_t row, int32_t col) const {
+    if (row < 0 || row >= (int32_t)this->n_rows) return 0;
+    if (col < 0 || col >= (int32_t)this->n_cols) return 0;
+
+    const uint8_t *chunk = this->chunks[this->get_chunk_idx(row, col)].get();
+    return chunk ? chunk[this->get_tile_idx(row, col)] : 0;
+}
+
+bool TileLayer::set(int32_t row, int32_t col, uint8_t tile) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return false;
+    if (col < 0 || col >= (int32_t)this->n_cols) return false;
+
+    uint32_t chunk_idx = this->get_chunk_idx(row, col);
+    std::unique_ptr<uint8_t[]> &chunk = this->chunks[chunk_idx];
+    if (!chunk) {
+        if (tile == 0) return false;
+        chunk = std::make_unique<uint8_t[]>(this->chunk_size * this->chunk_size);
+    }
+
+    uint8_t &old_tile = chunk[this->get_tile_idx(row, col)];
+    if (old_tile == tile) return false;
+
+    int32_t d_n_tiles = (tile != 0) - (old_tile != 0);
+    this->chunk_n_tiles[chunk_idx] += d_n_tiles;
+    this->n_tiles += d_n_tiles;
+    old_tile = tile;
+
+    // The last tile gone frees the chunk
+    if (this->chunk_n_tiles[chunk_idx] == 0) chunk.reset();
+    this->is_chunk_changed[chunk_idx] = 1;
+    return true;
+}
+
+void TileLayer::publish_changes(int32_t row0, int32_t col0, int32_t row1, int32_t col1) {
+    row0 = std::max(row0, 0);
+    col0 = std::max(col0, 0);
+    row1 = std::min(row1, (int32_t)this->n_rows - 1);
+    col1 = std::min(col1, (int32_t)this->n_cols - 1);
+    if (row0 > row1 || col0 > col1) return;
+
+    for (int32_t chunk_row = row0 / this->chunk_size;
+         chunk_row <= row1 / (int32_t)this->chunk_size;
+         ++chunk_row) {
+        for (int32_t chunk_col = col0 / this->chunk_size;
+             chunk_col <= col1 / (int32_t)this->chunk_size;
+             ++chunk_col) {
+            uint32_t chunk_idx = chunk_row * this->n_chunk_cols + chunk_col;
+            if (!this->is_chunk_changed[chunk_idx]) continue;
+
+            this->is_chunk_changed[chunk_idx] = 0;
+            this->chunk_versions[chunk_idx] += 1;
+        }
+    }
+}
+
+uint32_t TileLayer::get_chunk_version(uint32_t chunk_row, uint32_t chunk_col) const {
+    return this->chunk_versions[chunk_row * this->n_chunk_cols + chunk_col];
+}
+
+uint32_t TileLayer::get_n_tiles() const {
+    return this->n_tiles;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One layer of a layered grid: square chunks of row-major tiles, 0 being
+// empty. A chunk is allocated on its first tile and freed with its last,
+// so empty regions take no memory.
+//
+// Dirty tracking is a version per chunk. Writes only flag their chunk, the
+// owner publishes them (e.g. from its change bus) with publish_changes(),
+// which bumps the versions of the flagged chunks. What is built from the
+// layer (e.g. render batches) keeps the versions it was built from and
+// rebuilds only the chunks whose version moved.
+//
+// Versions start at 1, so 0 is never current.
+class TileLayer {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+    uint32_t chunk_size;
+    uint32_t n_chunk_rows;
+    uint32_t n_chunk_cols;
+
+    // nullptr while empty
+    std::vector<std::unique_ptr<uint8_t[]>> chunks;
+    std::vector<uint32_t> chunk_n_tiles;
+    std::vector<uint32_t> chunk_versions;
+    std::vector<uint8_t> is_chunk_changed;
+    uint32_t n_tiles = 0;
+
+    uint32_t get_chunk_idx(int32_t row, int32_t col) const;
+    uint32_t get_tile_idx(int32_t row, int32_t col) const;
+
+public:
+    TileLayer(uint32_t n_rows, uint32_t n_cols, uint32_t chunk_size);
+
+    uint32_t get_n_rows() const;
+    uint32_t get_n_cols() const;
+    uint32_t get_chunk_size() const;
+    uint32_t get_n_chunk_rows() const;
+    uint32_t get_n_chunk_cols() const;
+
+    // Out of bounds cells read as empty and ignore the writes. set()
+    // returns whether the tile changed
+    uint8_t get(int32_t row, int32_t col) const;
+    bool set(int32_t row, int32_t col, uint8_t tile);
+
+    // Bumps the versions of the chunks changed in the inclusive range
+    void publish_changes(int32_t row0, int32_t col0, int32_t row1, int32_t col1);
+    uint32_t get_chunk_version(uint32_t chunk_row, uint32_t chunk_col) const;
+
+    // Non-empty tiles, a layer without any can be skipped as a whole
+    uint32_t get_n_tiles() const;
+};
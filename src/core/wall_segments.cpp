@@ -0,0 +1,139 @@
+#include "wall_segments.hpp"
+
+#include "geometry.hpp"
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+WallSegments::WallSegments(uint32_t n_rows, uint32_t n_cols, Vector2 origin)
+    : n_rows(n_rows)
+    , n_cols(n_cols)
+    , origin(origin)
+    , occluders(n_rows, n_cols)
+    , h_lines(n_rows + 1)
+    , v_lines(n_cols + 1)
+    , is_h_line_dirty(n_rows + 1, 0)
+    , is_v_line_dirty(n_cols + 1, 0) {}
+
+bool WallSegments::is_occluder(int32_t row, int32_t col) const {
+    return this->occluders.get(row, col);
+}
+
+const GridMask &WallSegments::get_occluders() const {
+    return this->occluders;
+}
+
+void WallSegments::set_occluder(int32_t row, int32_t col, bool is_occluder) {
+    if (row < 0 || row >= (int32_t)this->n_rows) return;
+    if (col < 0 || col >= (int32_t)this->n_cols) return;
+    if (this->occluders.get(row, col) == is_occluder) return;
+
+    this->occluders.set(row, col, is_occluder);
+    this->mark_h_line(row);
+    this->mark_h_line(row + 1);
+    this->mark_v_line(col);
+    this->mark_v_line(col + 1);
+}
+
+void WallSegments::mark_h_line(uint32_t row) {
+    if (this->is_h_line_dirty[row]) return;
+    this->is_h_line_dirty[row] = 1;
+    this->dirty_h_line_idxs.push_back(row);
+}
+
+void WallSegments::mark_v_line(uint32_t col) {
+    if (this->is_v_line_dirty[col]) return;
+    this->is_v_line_dirty[col] = 1;
+    this->dirty_v_line_idxs.push_back(col);
+}
+
+void WallSegments::build_h_line(uint32_t row) {
+    // An edge is on the outline if exactly one of the two cells it
+    // separates is an occluder, contiguous edges merge into one segment
+    std::vector<Segment> &segments = this->h_lines[row];
+    segments.clear();
+
+    float y = this->origin.y + row;
+    int32_t run_start = -1;
+    for (int32_t col = 0; col <= (int32_t)this->n_cols; ++col) {
+        bool is_edge = col < (int32_t)this->n_cols
+                       && this->occluders.get(row - 1, col)
+                              != this->occluders.get(row, col);
+        if (is_edge && run_start < 0) run_start = col;
+        if (is_edge || run_start < 0) continue;
+
+        segments.push_back(
+            {{this->origin.x + run_start, y}, {this->origin.x + col, y}}
+        );
+        run_start = -1;
+    }
+}
+
+void WallSegments::build_v_line(uint32_t col) {
+    std::vector<Segment> &segments = this->v_lines[col];
+    segments.clear();
+
+    float x = this->origin.x + col;
+    int32_t run_start = -1;
+    for (int32_t row = 0; row <= (int32_t)this->n_rows; ++row) {
+        bool is_edge = row < (int32_t)this->n_rows
+                       && this->occluders.get(row, col - 1)
+                              != this->occluders.get(row, col);
+        if (is_edge && run_start < 0) run_start = row;
+        if (is_edge || run_start < 0) continue;
+
+        segments.push_back(
+            {{x, this->origin.y + run_start}, {x, this->origin.y + row}}
+        );
+        run_start = -1;
+    }
+}
+
+void WallSegments::update() {
+    for (uint32_t row : this->dirty_h_line_idxs) {
+        this->build_h_line(row);
+        this->is_h_line_dirty[row] = 0;
+    }
+    for (uint32_t col : this->dirty_v_line_idxs) {
+        this->build_v_line(col);
+        this->is_v_line_dirty[col] = 0;
+    }
+
+    this->dirty_h_line_idxs.clear();
+    this->dirty_v_line_idxs.clear();
+}
+
+void WallSegments::query(Rectangle rect, std::vector<Segment> &segments) const {
+    float left = rect.x;
+    float right = rect.x + rect.width;
+    float top = rect.y;
+    float bot = rect.y + rect.height;
+
+    int32_t first_row = std::max(0.0f, std::ceil(top - this->origin.y));
+    int32_t last_row = std::min((float)this->n_rows, std::floor(bot - this->origin.y));
+    for (int32_t row = first_row; row <= last_row; ++row) {
+        for (const Segment &segment : this->h_lines[row]) {
+            if (segment.end.x < left || segment.start.x > right) continue;
+            segments.push_back(segment);
+        }
+    }
+
+    int32_t first_col = std::max(0.0f, std::ceil(left - this->origin.x));
+    int32_t last_col = std::min((float)this->n_cols, std::floor(right - this->origin.x));
+    for (int32_t col = first_col; col <= last_col; ++col) {
+        for (const Segment &segment : this->v_lines[col]) {
+            if (segment.end.y < top || segment.start.y > bot) continue;
+            segments.push_back(segment);
+        }
+    }
+}
+
+uint32_t WallSegments::get_n_segments() const {
+    uint32_t n = 0;
+    for (auto &segments : this->h_lines) n += segments.size();
+    for (auto &segments : this->v_lines) n += segments.size();
+    return n;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "geometry.hpp"
+#include "grid_mask.hpp"
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+// Outline of the occluder cells merged into maximal segments along the grid
+// lines: a straight wall run of any length gives just a couple of segments
+// and the edges shared by two occluders are dropped.
+//
+// Changing a cell only marks the two horizontal and two vertical grid lines
+// along its edges, those are re-merged on update().
+class WallSegments {
+private:
+    uint32_t n_rows;
+    uint32_t n_cols;
+
+    // World position of the grid's top left corner, cells are unit squares
+    Vector2 origin;
+
+    GridMask occluders;
+
+    // Segments on the horizontal line above each row (and below the last
+    // one) and on the vertical line left to each col (and right to the last)
+    std::vector<std::vector<Segment>> h_lines;
+    std::vector<std::vector<Segment>> v_lines;
+
+    std::vector<uint32_t> dirty_h_line_idxs;
+    std::vector<uint32_t> dirty_v_line_idxs;
+    std::vector<uint8_t> is_h_line_dirty;
+    std::vector<uint8_t> is_v_line_dirty;
+
+    void mark_h_line(uint32_t row);
+    void mark_v_line(uint32_t col);
+    void build_h_line(uint32_t row);
+    void build_v_line(uint32_t col);
+
+public:
+    WallSegments(uint32_t n_rows, uint32_t n_cols, Vector2 origin);
+
+    bool is_occluder(int32_t row, int32_t col) const;
+    const GridMask &get_occluders() const;
+    void set_occluder(int32_t row, int32_t col, bool is_occluder);
+    void update();
+
+    // Appends the segments which overlap the world space rect
+    void query(Rectangle rect, std::vector<Segment> &segments) const;
+    uint32_t get_n_segments() const;
+};
@@ -2,9 +2,14 @@
 
 #include "raylib.h"
 #include "raymath.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
-#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace the_shell {
 // -----------------------------------------------------------------------
@@ -14,100 +19,54 @@ Camera::Camera(float view_width, Vector2 target)
     , target(target) {}
 
 // -----------------------------------------------------------------------
-// item
-Item::Item() = default;
-
-Item::Item(ItemType type, Sprite sprite)
-    : type(type)
-    , sprite(sprite) {}
-
-bool Item::is_none() {
-    return this->type == ItemType::NONE;
-}
-
-bool Item::is_wall() {
-    return this->type == ItemType::WALL;
-}
-
-bool Item::is_door() {
-    return this->type == ItemType::DOOR;
+// tiles
+// The tile layers have no sprites, they're drawn as colored squares. The
+// shader has no translucency, so the zones are a marker in the cell center
+// instead of a tint over it
+static Color get_tile_color(ItemType item_type) {
+    switch (item_type) {
+        case ItemType::FLOOR: return {70, 60, 50, 255};
+        case ItemType::ROOF: return {110, 45, 35, 255};
+        case ItemType::ZONE: return {230, 200, 40, 255};
+        default: return BLANK;
+    }
 }
 
-bool Item::is_wall_or_door() {
-    return this->is_wall() || this->is_door();
+static float get_tile_size(ItemType item_type) {
+    return item_type == ItemType::ZONE ? 0.4 : 1.0;
 }
 
 // -----------------------------------------------------------------------
-// cell
-Cell::Cell() = default;
-
-Cell::Cell(Vector2 position)
-    : position(position) {}
-
-Vector2 Cell::get_position() {
-    return this->position;
-}
-
-Rectangle Cell::get_rect() {
-    return {
-        .x = this->position.x - 0.5f,
-        .y = this->position.y - 0.5f,
-        .width = 1.0,
-        .height = 1.0
-    };
-}
-
-CellNeighbors::CellNeighbors() {
-    this->cells.fill(nullptr);
-}
-
-std::array<Cell *, 4> CellNeighbors::get_orthos() {
-    return {cells[0], cells[2], cells[4], cells[6]};
+// impostors
+static uint64_t get_impostor_key(
+    GridLayer layer, uint32_t chunk_row, uint32_t chunk_col
+) {
+    return (uint64_t)layer << 48 | (uint64_t)chunk_row << 24 | chunk_col;
 }
 
-// -----------------------------------------------------------------------
-// components
-struct Position_C : public Vector2 {
-    Position_C(const Vector2 &vec)
-        : Vector2{vec.x, vec.y} {}
-};
-
-struct Door_C {};
-struct ResolveCollision_C {};
-struct Renderable_C : public Renderable {};
-
 // -----------------------------------------------------------------------
 // game
 Game::Game()
     : renderer(1920, 1080)
-    , camera(30.0, {0.0, 0.0}) {
-
-    // -------------------------------------------------------------------
-    // inventory
-    SpriteSheet &sheet = this->resources.sprite_sheet;
-    this->items.emplace_back(ItemType::WALL, sheet.get_sprite(sheet_0::wall));
-    this->items.emplace_back(ItemType::DOOR, sheet.get_sprite(sheet_0::door));
-
-    // -------------------------------------------------------------------
-    // entities
-    this->player = this->registry.create();
-    this->registry.emplace<Position_C>(this->player, Position_C({0.0, 0.0}));
-    this->registry.emplace<ResolveCollision_C>(this->player);
-    this->registry.emplace<Renderable_C>(
-        this->player, Renderable_C::create_circle(0.5, 1.0, BLUE)
+    , impostor_atlas(impostor_atlas_size, impostor_px_per_cell * tile_chunk_size)
+    , camera(30.0, {0.0, 0.0})
+    , thread_pool(std::max(1u, std::thread::hardware_concurrency()))
+    , world(
+          grid_n_rows, grid_n_cols, this->thread_pool, this->resources.animation_table
+      ) {
+
+    this->world.registry.storage<Renderable_C>();
+    this->world.registry.emplace<Renderable_C>(
+        this->world.player, Renderable_C::create_circle(0.5, 1.0, BLUE)
+    );
+    this->world.registry.emplace<Light_C>(
+        this->world.player,
+        Light_C{.radius = player_light_radius, .color = player_light_color}
     );
+}
 
-    // -------------------------------------------------------------------
-    // grid
-    Rectangle world_rect = this->get_world_rect();
-    for (uint32_t idx = 0; idx < grid_n_rows * grid_n_cols; ++idx) {
-        uint32_t row = idx / grid_n_cols;
-        uint32_t col = idx % grid_n_cols;
-        float x = world_rect.x + (float)col + 0.5;
-        float y = world_rect.y + (float)row + 0.5;
-        Vector2 position = {x, y};
-        this->cells[idx] = Cell(position);
-    }
+void Game::record_input(std::string file_path) {
+    this->input_recorder = std::make_unique<InputRecorder>(file_path);
 }
 
 void Game::run() {
@@ -120,148 +79,371 @@ void Game::run() {
 // -----------------------------------------------------------------------
 // update
 void Game::update() {
+    // Input polls raylib, so it stays on the main thread
     this->update_input();
-    this->update_active_item_placement();
-    this->update_player();
-    this->update_doors();
-    this->update_collisions();
+
+    // Quick save and load, between the ticks
+    try {
+        if (IsKeyPressed(KEY_F5)) this->world.save(save_file_path);
+        if (IsKeyPressed(KEY_F9)) this->world.load(save_file_path);
+    } catch (const std::exception &e) {
+        TraceLog(LOG_WARNING, "%s", e.what());
+    }
+
+    if (this->input_recorder) this->input_recorder->record(this->input);
+    this->world.update(this->input);
+
+    // Roofs hide while the player is under one
+    Vector2 player_position = this->world.registry.get<Position_C>(this->world.player);
+    CellCoord player_coord = this->world.get_cell_coord(player_position);
+    this->is_roof_visible = this->world.get_layer_item_type(player_coord, GridLayer::ROOF)
+                            == ItemType::NONE;
 }
 
 void Game::update_input() {
-    this->dt = GetFrameTime();
+    this->input.dt = GetFrameTime();
 
     Vector2 screen_size = this->renderer.get_screen_size();
     Vector2 mouse_position_screen = GetMousePosition();
 
     this->mouse_position_screen = mouse_position_screen;
 
-    {  // mouse_position_world
+    // Zoom, by the same factor per wheel notch at any scale
+    float view_width = camera.view_width * std::pow(zoom_step, -GetMouseWheelMove());
+    camera.view_width = std::clamp(view_width, min_view_width, max_view_width);
+
+    {  // view_rect and mouse_position_world
         Vector2 cursor = Vector2Divide(mouse_position_screen, screen_size);
         float aspect = screen_size.x / screen_size.y;
         float view_height = camera.view_width / aspect;
         Vector2 center = camera.target;
         float left = center.x - 0.5 * camera.view_width;
         float top = center.y - 0.5 * view_height;
+        this->view_rect = {
+            .x = left, .y = top, .width = camera.view_width, .height = view_height};
+
         float x = left + camera.view_width * cursor.x;
         float y = top + view_height * cursor.y;
-        this->mouse_position_world = {.x = x, .y = y};
+        this->input.mouse_position_world = {.x = x, .y = y};
     }
 
-    this->mouse_position_grid = this->round_position(this->mouse_position_world);
+    this->mouse_position_grid = this->world.round_position(
+        this->input.mouse_position_world
+    );
 
     this->is_lmb_pressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
     this->is_lmb_released = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
-    this->is_lmb_down = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    this->input.is_lmb_down = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+
+    this->input.is_w_down = IsKeyDown(KEY_W);
+    this->input.is_s_down = IsKeyDown(KEY_S);
+    this->input.is_a_down = IsKeyDown(KEY_A);
+    this->input.is_d_down = IsKeyDown(KEY_D);
 
-    this->is_w_down = IsKeyDown(KEY_W);
-    this->is_s_down = IsKeyDown(KEY_S);
-    this->is_a_down = IsKeyDown(KEY_A);
-    this->is_d_down = IsKeyDown(KEY_D);
+    bool is_ctrl_down = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    this->input.is_undo_pressed = is_ctrl_down && IsKeyPressed(KEY_Z);
+    this->input.is_redo_pressed = is_ctrl_down && IsKeyPressed(KEY_Y);
 }
 
-void Game::update_active_item_placement() {
-    Vector2 mouse_position = this->mouse_position_grid;
+// -----------------------------------------------------------------------
+// draw
+void Game::draw() {
+    this->renderer.begin_drawing();
+
+    // The impostor redraws set their own viewport and camera
+    if (this->is_impostor_lod()) this->update_impostors();
 
-    Item *item = this->get_active_item();
-    Cell *cell = this->get_cell(mouse_position);
+    this->renderer.set_camera(this->camera.target, this->camera.view_width);
+    this->draw_layer(GridLayer::FLOOR);
+    this->draw_lights();
+    draw_renderables(this->renderer, this->world.registry);
+    this->draw_layer(GridLayer::WALL);
+    this->draw_layer(GridLayer::ROOF);
+    this->draw_layer(GridLayer::OVERLAY);
+    this->draw_active_item_ghost();
 
-    if (!item) return;
-    if (!cell) return;
-    if (this->is_ui_interacted) return;
-    if (!this->is_lmb_down) return;
-    if (!this->can_place_item(item, mouse_position)) return;
+    this->renderer.set_screen_camera();
+    this->input.is_ui_interacted = false;
+    this->update_and_draw_quickbar();
 
-    this->place_item(item, mouse_position);
+    this->renderer.end_drawing();
 }
 
-void Game::update_player() {
-    static float speed = 3.0;
+void draw_renderables(Renderer &renderer, entt::registry &registry) {
+    auto view = registry.view<Renderable_C, Position_C>();
+    for (auto entity : view) {
+        auto [renderable, position] = view.get(entity);
+        renderer.draw_renderable(renderable, position);
+    }
+}
 
-    auto &position = registry.get<Position_C>(this->player);
-    Vector2 step = Vector2Zero();
-    if (this->is_w_down) step.y -= 1.0;
-    if (this->is_s_down) step.y += 1.0;
-    if (this->is_a_down) step.x -= 1.0;
-    if (this->is_d_down) step.x += 1.0;
+void Game::draw_lights() {
+    auto view = this->world.registry.view<Position_C, Light_C>();
+    for (auto entity : view) {
+        auto [position, light] = view.get(entity);
+        this->renderer.draw_light(position, light.polygon, light.color);
+    }
+}
 
-    step = Vector2Scale(Vector2Normalize(step), this->dt * speed);
-    position = Position_C(Vector2Add(step, position));
+void Game::draw_grid_items() {
+    // Only the cells on screen
+    Rectangle view_rect = this->view_rect;
+    CellCoord coord0 = this->world.get_cell_coord({view_rect.x, view_rect.y});
+    CellCoord coord1 = this->world.get_cell_coord(
+        {view_rect.x + view_rect.width, view_rect.y + view_rect.height}
+    );
+    for (int32_t row = coord0.row; row <= coord1.row; ++row) {
+        for (int32_t col = coord0.col; col <= coord1.col; ++col) {
+            Cell *cell = this->world.get_cell({.row = row, .col = col});
+            if (!cell || cell->item.type == ItemType::NONE) continue;
+
+            Sprite sprite = this->resources.sprite_sheet.get_sprite(
+                cell->item.sprite_idx
+            );
+            float base_scale = 1.0 / sprite.src.width;
+            Renderable renderable = Renderable::create_sprite(
+                sprite, Pivot::CENTER_CENTER, base_scale
+            );
+            this->renderer.draw_renderable(
+                renderable, this->world.get_cell_position({.row = row, .col = col})
+            );
+        }
+    }
 }
 
-void Game::update_doors() {
-    auto player_position = registry.get<Position_C>(this->player);
+void Game::draw_layer(GridLayer layer) {
+    if (!this->is_layer_drawn(layer)) return;
 
-    auto view = registry.view<Cell *, Door_C>();
-    for (auto entity : view) {
-        auto [cell] = view.get(entity);
-        Vector2 cell_position = cell->get_position();
-        auto sprite_idx = this->suggest_item_sprite_idx(cell_position, ItemType::DOOR);
-        if (Vector2Distance(player_position, cell_position) <= door_open_dist) {
-            sprite_idx += 2;
+    if (this->is_impostor_lod()) {
+        this->draw_layer_impostors(layer);
+        return;
+    }
+
+    // Per cell, for the door animations
+    if (layer == GridLayer::WALL) {
+        this->draw_grid_items();
+        return;
+    }
+
+    CellRect chunks;
+    if (!this->get_view_chunks(chunks)) return;
+
+    for (int32_t chunk_row = chunks.row0; chunk_row <= chunks.row1; ++chunk_row) {
+        for (int32_t chunk_col = chunks.col0; chunk_col <= chunks.col1; ++chunk_col) {
+            this->draw_chunk_batch(this->get_chunk_batch(layer, chunk_row, chunk_col));
         }
-        cell->item.sprite = this->resources.sprite_sheet.get_sprite(sprite_idx);
     }
 }
 
-void Game::update_collisions() {
-    auto player_position = registry.get<Position_C>(this->player);
+void Game::draw_layer_impostors(GridLayer layer) {
+    CellRect chunks;
+    if (!this->get_view_chunks(chunks)) return;
+
+    float chunk_size = tile_chunk_size;
+    for (int32_t chunk_row = chunks.row0; chunk_row <= chunks.row1; ++chunk_row) {
+        for (int32_t chunk_col = chunks.col0; chunk_col <= chunks.col1; ++chunk_col) {
+            uint64_t key = get_impostor_key(layer, chunk_row, chunk_col);
+            int32_t slot_idx = this->impostor_atlas.find_slot(key);
+            if (slot_idx != -1) {
+                Vector2 position = this->world.get_cell_position(
+                    {.row = chunk_row * (int32_t)tile_chunk_size,
+                     .col = chunk_col * (int32_t)tile_chunk_size}
+                );
+                Rectangle dst = {
+                    .x = position.x - 0.5f,
+                    .y = position.y - 0.5f,
+                    .width = chunk_size,
+                    .height = chunk_size};
+                this->impostor_atlas.draw_slot(slot_idx, dst);
+                continue;
+            }
 
-    auto view = registry.view<Position_C, ResolveCollision_C>();
-    for (auto entity : view) {
-        auto [position] = view.get(entity);
-
-        CellNeighbors nb = this->get_cell_neighbors(position);
-        for (uint32_t i = 0; i < nb.cells.size(); ++i) {
-            Cell *cell = nb.cells[i];
-            if (!cell || cell->item.is_none()) continue;
-            if (cell->item.is_door()) {
-                if (Vector2Distance(player_position, cell->get_position())
-                    <= door_open_dist) {
+            // Not drawn yet (or with nothing to show), or the atlas is full
+            this->draw_chunk_batch(this->get_chunk_batch(layer, chunk_row, chunk_col));
+        }
+    }
+}
+
+void Game::update_impostors() {
+    this->impostor_atlas.begin_frame();
+
+    CellRect chunks;
+    if (!this->get_view_chunks(chunks)) return;
+
+    // The missing and stale impostors on screen are redrawn, a few per
+    // frame: the others show their stale version or their batch meanwhile
+    uint32_t n_redraws = 0;
+    bool is_updating = false;
+    for (uint32_t layer_idx = 0; layer_idx < n_grid_layers; ++layer_idx) {
+        GridLayer layer = (GridLayer)layer_idx;
+        if (!this->is_layer_drawn(layer)) continue;
+
+        for (int32_t chunk_row = chunks.row0; chunk_row <= chunks.row1; ++chunk_row) {
+            for (int32_t chunk_col = chunks.col0; chunk_col <= chunks.col1;
+                 ++chunk_col) {
+                uint64_t key = get_impostor_key(layer, chunk_row, chunk_col);
+                uint32_t version = this->get_chunk_version(layer, chunk_row, chunk_col);
+                int32_t slot_idx = this->impostor_atlas.find_slot(key);
+                if (slot_idx != -1
+                    && this->impostor_atlas.get_slot_version(slot_idx) == version) {
                     continue;
                 }
-            }
+                if (n_redraws == max_impostor_redraws) continue;
+
+                ChunkBatch &batch = this->get_chunk_batch(layer, chunk_row, chunk_col);
+
+                // Empty chunks take no slot
+                if (batch.renderables.empty()) {
+                    this->impostor_atlas.release_slot(key);
+                    continue;
+                }
+
+                if (slot_idx == -1) slot_idx = this->impostor_atlas.acquire_slot(key);
+                if (slot_idx == -1) continue;
 
-            Rectangle rect = cell->get_rect();
-            Vector2 mtv = get_circle_rect_mtv(position, 0.5, rect);
-            position = Vector2Add(position, mtv);
+                if (!is_updating) {
+                    this->impostor_atlas.begin_update();
+                    is_updating = true;
+                }
+
+                // Square camera over the chunk
+                Vector2 position = this->world.get_cell_position(
+                    {.row = chunk_row * (int32_t)tile_chunk_size,
+                     .col = chunk_col * (int32_t)tile_chunk_size}
+                );
+                float half_size = 0.5 * tile_chunk_size;
+                Vector2 center = {
+                    .x = position.x - 0.5f + half_size,
+                    .y = position.y - 0.5f + half_size};
+                this->impostor_atlas.begin_slot(slot_idx);
+                this->renderer.set_camera(center, tile_chunk_size, 1.0);
+                this->draw_chunk_batch(batch);
+
+                this->impostor_atlas.set_slot_version(slot_idx, version);
+                n_redraws += 1;
+            }
         }
     }
+
+    if (is_updating) this->impostor_atlas.end_update();
 }
 
-// -----------------------------------------------------------------------
-// draw
-void Game::draw() {
-    this->renderer.begin_drawing();
+bool Game::is_impostor_lod() {
+    float px_per_cell = this->renderer.get_screen_size().x / this->camera.view_width;
+    return px_per_cell < impostor_lod_px_per_cell;
+}
 
-    this->renderer.set_camera(this->camera.target, this->camera.view_width);
-    this->draw_renderables();
-    this->draw_grid_items();
-    this->draw_active_item_ghost();
+bool Game::is_layer_drawn(GridLayer layer) {
+    if (layer == GridLayer::ROOF && !this->is_roof_visible) return false;
 
-    this->renderer.set_screen_camera();
-    this->is_ui_interacted = false;
-    this->update_and_draw_quickbar();
+    const TileLayer *tiles = this->world.get_tile_layer(layer);
+    return !tiles || tiles->get_n_tiles() != 0;
+}
 
-    this->renderer.end_drawing();
+bool Game::get_view_chunks(CellRect &chunks) {
+    // The tile layers span the grid
+    const TileLayer *tiles = this->world.get_tile_layer(GridLayer::FLOOR);
+
+    Rectangle view_rect = this->view_rect;
+    CellCoord coord0 = this->world.get_cell_coord({view_rect.x, view_rect.y});
+    CellCoord coord1 = this->world.get_cell_coord(
+        {view_rect.x + view_rect.width, view_rect.y + view_rect.height}
+    );
+    int32_t row0 = std::max(coord0.row, 0);
+    int32_t col0 = std::max(coord0.col, 0);
+    int32_t row1 = std::min(coord1.row, (int32_t)tiles->get_n_rows() - 1);
+    int32_t col1 = std::min(coord1.col, (int32_t)tiles->get_n_cols() - 1);
+    if (row0 > row1 || col0 > col1) return false;
+
+    int32_t chunk_size = tile_chunk_size;
+    chunks = {
+        .row0 = row0 / chunk_size,
+        .col0 = col0 / chunk_size,
+        .row1 = row1 / chunk_size,
+        .col1 = col1 / chunk_size};
+    return true;
 }
 
-void Game::draw_renderables() {
-    auto view = this->registry.view<Renderable_C, Position_C>();
-    for (auto entity : view) {
-        auto [renderable, position] = view.get(entity);
-        renderer.draw_renderable(renderable, position);
+uint32_t Game::get_chunk_version(
+    GridLayer layer, uint32_t chunk_row, uint32_t chunk_col
+) {
+    if (layer == GridLayer::WALL) {
+        return this->world.get_wall_chunk_version(chunk_row, chunk_col);
     }
+    return this->world.get_tile_layer(layer)->get_chunk_version(chunk_row, chunk_col);
 }
 
-void Game::draw_grid_items() {
-    for (Cell &cell : this->cells) {
-        if (cell.item.type == ItemType::NONE) continue;
+ChunkBatch &Game::get_chunk_batch(
+    GridLayer layer, uint32_t chunk_row, uint32_t chunk_col
+) {
+    const TileLayer *tiles = this->world.get_tile_layer(GridLayer::FLOOR);
+    uint32_t n_chunk_cols = tiles->get_n_chunk_cols();
 
-        float base_scale = 1.0 / cell.item.sprite.src.width;
-        Renderable renderable = Renderable::create_sprite(
-            cell.item.sprite, Pivot::CENTER_CENTER, base_scale
-        );
-        this->renderer.draw_renderable(renderable, cell.get_position());
+    std::vector<ChunkBatch> &batches = this->chunk_batches[(uint32_t)layer];
+    batches.resize(tiles->get_n_chunk_rows() * n_chunk_cols);
+
+    // Rebuilt once the chunk changed
+    ChunkBatch &batch = batches[chunk_row * n_chunk_cols + chunk_col];
+    uint32_t version = this->get_chunk_version(layer, chunk_row, chunk_col);
+    if (batch.version != version) {
+        this->build_chunk_batch(layer, chunk_row, chunk_col, batch);
+        batch.version = version;
+    }
+
+    return batch;
+}
+
+void Game::build_chunk_batch(
+    GridLayer layer, uint32_t chunk_row, uint32_t chunk_col, ChunkBatch &batch
+) {
+    batch.renderables.clear();
+    batch.positions.clear();
+
+    const TileLayer *tiles = this->world.get_tile_layer(layer);
+    const TileLayer *grid = this->world.get_tile_layer(GridLayer::FLOOR);
+    int32_t chunk_size = tile_chunk_size;
+    int32_t row0 = chunk_row * chunk_size;
+    int32_t col0 = chunk_col * chunk_size;
+    int32_t row1 = std::min(row0 + chunk_size, (int32_t)grid->get_n_rows());
+    int32_t col1 = std::min(col0 + chunk_size, (int32_t)grid->get_n_cols());
+    for (int32_t row = row0; row < row1; ++row) {
+        for (int32_t col = col0; col < col1; ++col) {
+            CellCoord coord = {.row = row, .col = col};
+
+            if (tiles) {
+                ItemType item_type = (ItemType)tiles->get(row, col);
+                if (item_type == ItemType::NONE) continue;
+
+                float size = get_tile_size(item_type);
+                batch.renderables.push_back(Renderable::create_rectangle(
+                    Pivot::CENTER_CENTER, size, size, 1.0, get_tile_color(item_type)
+                ));
+            } else {
+                Cell *cell = this->world.get_cell(coord);
+                if (cell->item.type == ItemType::NONE) continue;
+
+                // Doors as closed, their animation frames aren't versioned
+                uint32_t sprite_idx = cell->item.sprite_idx;
+                if (cell->item.type == ItemType::DOOR) {
+                    sprite_idx = this->world.suggest_item_sprite_idx(
+                        coord, cell->item.type
+                    );
+                }
+                Sprite sprite = this->resources.sprite_sheet.get_sprite(sprite_idx);
+                float base_scale = 1.0 / sprite.src.width;
+                batch.renderables.push_back(Renderable::create_sprite(
+                    sprite, Pivot::CENTER_CENTER, base_scale
+                ));
+            }
+
+            batch.positions.push_back(this->world.get_cell_position(coord));
+        }
+    }
+}
+
+void Game::draw_chunk_batch(const ChunkBatch &batch) {
+    for (uint32_t i = 0; i < batch.renderables.size(); ++i) {
+        this->renderer.draw_renderable(batch.renderables[i], batch.positions[i]);
     }
 }
 
@@ -269,21 +451,29 @@ void Game::draw_active_item_ghost() {
     Vector2 position = this->mouse_position_grid;
     Item *item = this->get_active_item();
 
-    if (this->is_ui_interacted) return;
+    if (this->input.is_ui_interacted) return;
     if (!item) return;
 
     Color color;
-    if (this->can_place_item(item, position)) {
+    if (this->world.can_place_item(item, position)) {
         color = ColorAlpha(GREEN, 0.3);
     } else {
         color = ColorAlpha(RED, 0.3);
     }
 
-    float base_scale = 1.0 / item->sprite.src.width;
+    if (get_item_layer(item->type) != GridLayer::WALL) {
+        Renderable renderable = Renderable::create_rectangle(
+            Pivot::CENTER_CENTER, 1.0, 1.0, 1.0, color
+        );
+        this->renderer.draw_renderable(renderable, position);
+        return;
+    }
 
     Sprite sprite = this->resources.sprite_sheet.get_sprite(
-        this->suggest_item_sprite_idx(position, item->type)
+        this->world.suggest_item_sprite_idx(position, item->type)
     );
+    float base_scale = 1.0 / sprite.src.width;
+
     Renderable renderable = Renderable::create_sprite(
         sprite, Pivot::CENTER_CENTER, base_scale, 1.0, color
     );
@@ -296,8 +486,10 @@ void Game::update_and_draw_quickbar() {
     static float pad = 15.0;
     static Color pane_color{20, 20, 20, 255};
 
-    int n_items = this->items.size();
-    float pane_width = item_size * n_items + 3.0 * pad;
+    std::vector<Item> &items = this->world.items;
+
+    int n_items = items.size();
+    float pane_width = item_size * n_items + (n_items + 1) * pad;
     float pane_height = item_size + 2.0 * pad;
     float x = 0.5 * (screen_size.x - pane_width);
     float y = screen_size.y - 0.5 * pane_height;
@@ -307,19 +499,25 @@ void Game::update_and_draw_quickbar() {
         Pivot::LEFT_CENTER, pane_width, pane_height, 1.0, pane_color
     );
     this->renderer.draw_renderable(renderable, position);
-    this->is_ui_interacted |= renderable.check_collision_with_point(
+    this->input.is_ui_interacted |= renderable.check_collision_with_point(
         position, this->mouse_position_screen
     );
 
     position.x += pad;
-    for (uint32_t i = 0; i < this->items.size(); ++i) {
-        Item &item = this->items[i];
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        Item &item = items[i];
 
         position.x += 0.5 * item_size;
-        float base_scale = item_size / item.sprite.src.width;
-        Renderable renderable = Renderable::create_sprite(
-            item.sprite, Pivot::CENTER_CENTER, base_scale
+        Renderable renderable = Renderable::create_rectangle(
+            Pivot::CENTER_CENTER, item_size, item_size, 1.0, get_tile_color(item.type)
         );
+        if (get_item_layer(item.type) == GridLayer::WALL) {
+            Sprite sprite = this->resources.sprite_sheet.get_sprite(item.sprite_idx);
+            float base_scale = item_size / sprite.src.width;
+            renderable = Renderable::create_sprite(
+                sprite, Pivot::CENTER_CENTER, base_scale
+            );
+        }
 
         bool is_hovered = renderable.check_collision_with_point(
             position, this->mouse_position_screen
@@ -329,7 +527,7 @@ void Game::update_and_draw_quickbar() {
         } else if (this->is_lmb_released) {
             this->set_active_item(i);
             renderable.scale = 1.1;
-        } else if (this->is_lmb_down) {
+        } else if (this->input.is_lmb_down) {
             renderable.scale = 0.9;
         } else {
             renderable.scale = 1.1;
@@ -343,202 +541,14 @@ void Game::update_and_draw_quickbar() {
 // -----------------------------------------------------------------------
 // other
 Item *Game::get_active_item() {
-    int idx = this->active_item_idx;
-    if (idx >= 0 && (uint32_t)idx < this->items.size()) {
-        return &this->items[idx];
-    }
-
-    return nullptr;
+    return this->world.get_item(this->input.active_item_idx);
 }
 
 void Game::set_active_item(int item_idx) {
-    this->active_item_idx = item_idx;
+    this->input.active_item_idx = item_idx;
 }
 
 void Game::clear_active_item() {
-    this->active_item_idx = -1;
-}
-
-Rectangle Game::get_world_rect() {
-    static Rectangle rect = {
-        .x = -(float)grid_n_cols / 2.0f,
-        .y = -(float)grid_n_rows / 2.0f,
-        .width = (float)grid_n_cols,
-        .height = (float)grid_n_rows
-    };
-    return rect;
-}
-
-Cell *Game::get_cell(Vector2 position) {
-    Rectangle world_rect = this->get_world_rect();
-    if (!CheckCollisionPointRec(position, world_rect)) return nullptr;
-
-    uint32_t col = position.x - world_rect.x;
-    uint32_t row = position.y - world_rect.y;
-    uint32_t idx = row * grid_n_rows + col;
-
-    if (idx >= grid_n_rows * grid_n_cols) return nullptr;
-    return &this->cells[idx];
-}
-
-CellNeighbors Game::get_cell_neighbors(Vector2 position) {
-    CellNeighbors nb;
-
-    Cell *mid = this->get_cell(position);
-    if (mid) {
-        Vector2 p = mid->get_position();
-        nb.cells[0] = this->get_cell({p.x - 1.0f, p.y});
-        nb.cells[1] = this->get_cell({p.x - 1.0f, p.y - 1.0f});
-
-        nb.cells[2] = this->get_cell({p.x, p.y - 1.0f});
-        nb.cells[3] = this->get_cell({p.x + 1.0f, p.y - 1.0f});
-
-        nb.cells[4] = this->get_cell({p.x + 1.0f, p.y});
-        nb.cells[5] = this->get_cell({p.x + 1.0f, p.y + 1.0f});
-
-        nb.cells[6] = this->get_cell({p.x, p.y + 1.0f});
-        nb.cells[7] = this->get_cell({p.x - 1.0f, p.y + 1.0f});
-    }
-
-    return nb;
+    this->input.active_item_idx = -1;
 }
-
-Rectangle Game::get_occupied_rect(Vector2 position) {
-    float left_x = std::floor(position.x - 0.5);
-    float right_x = std::ceil(position.x + 0.5);
-    float top_y = std::floor(position.y - 0.5);
-    float bot_y = std::ceil(position.y + 0.5);
-    float width = right_x - left_x;
-    float height = bot_y - top_y;
-
-    return {.x = left_x, .y = top_y, .width = width, .height = height};
-}
-
-WallType Game::get_wall_type(Vector2 position) {
-    Cell *mid = this->get_cell(position);
-    if (!mid) return WallType::NONE;
-
-    if (!mid->item.is_wall_or_door()) return WallType::NONE;
-
-    auto nb = this->get_cell_neighbors(position).get_orthos();
-    bool walls[4];
-    for (int i = 0; i < 4; ++i) {
-        walls[i] = nb[i] && nb[i]->item.is_wall_or_door();
-    }
-
-    bool is_horizontal = walls[0] || walls[2];
-    bool is_vertical = walls[1] || walls[3];
-
-    if (is_horizontal && !is_vertical) return WallType::HORIZONTAL;
-    if (!is_horizontal && is_vertical) return WallType::VERTICAL;
-    return WallType::NONE;
-}
-
-Vector2 Game::round_position(Vector2 position) {
-    float x = std::floor(position.x) + 0.5;
-    float y = std::floor(position.y) + 0.5;
-    return {x, y};
-}
-
-bool Game::can_place_item(const Item *item, Vector2 position) {
-    static float build_radius = 4.0;
-
-    Cell *cell = this->get_cell(position);
-    if (!item) return false;
-    if (!cell) return false;
-
-    auto player_position = registry.get<Position_C>(this->player);
-    if (Vector2Distance(position, player_position) > build_radius) {
-        return false;
-    }
-
-    auto view = registry.view<Position_C, ResolveCollision_C>();
-    for (auto entity : view) {
-        auto [e_pos] = view.get(entity);
-        Rectangle rect = this->get_occupied_rect(e_pos);
-        if (CheckCollisionPointRec(position, rect)) {
-            return false;
-        }
-    }
-
-    switch (item->type) {
-        case ItemType::WALL: {
-            if (cell->item.type != ItemType::NONE) return false;
-            auto nb = this->get_cell_neighbors(position).get_orthos();
-            for (int i = 0; i < 4; ++i) {
-                Cell *cell = nb[i];
-                if (!cell) continue;
-                bool is_door = cell->item.is_door();
-                auto wall_type = this->get_wall_type(cell->get_position());
-                if (i % 2 == 0) {
-                    if (is_door && wall_type == WallType::VERTICAL) return false;
-                } else {
-                    if (is_door && wall_type == WallType::HORIZONTAL) return false;
-                }
-            }
-            return true;
-        }
-        case ItemType::DOOR: {
-            if (cell->item.type != ItemType::WALL) return false;
-            if (this->get_wall_type(position) != WallType::NONE) return true;
-            return false;
-        }
-        case ItemType::NONE: return false;
-        default: return false;
-    }
-}
-
-bool Game::place_item(const Item *item, Vector2 position) {
-    if (!this->can_place_item(item, position)) return false;
-
-    Cell *cell = this->get_cell(position);
-    cell->item = *item;
-
-    switch (cell->item.type) {
-        case the_shell::ItemType::DOOR:
-            cell->item.entity = this->registry.create();
-            this->registry.emplace<Door_C>(cell->item.entity);
-            this->registry.emplace<Cell *>(cell->item.entity, cell);
-            break;
-        default: break;
-    }
-
-    cell->item.sprite = this->resources.sprite_sheet.get_sprite(
-        this->suggest_item_sprite_idx(cell->get_position(), cell->item.type)
-    );
-    for (Cell *cell : this->get_cell_neighbors(position).get_orthos()) {
-        cell->item.sprite = this->resources.sprite_sheet.get_sprite(
-            this->suggest_item_sprite_idx(cell->get_position(), cell->item.type)
-        );
-    }
-
-    return true;
-}
-
-uint32_t Game::suggest_item_sprite_idx(Vector2 position, ItemType item_type) {
-    uint8_t idx = 0;
-
-    switch (item_type) {
-        case ItemType::WALL: {
-            auto nb = this->get_cell_neighbors(position).get_orthos();
-            idx = sheet_0::wall;
-            for (int i = 0; i < 4; ++i) {
-                Cell *cell = nb[i];
-                if (cell && cell->item.is_wall_or_door()) {
-                    idx += 1 << (4 - i - 1);
-                }
-            }
-        } break;
-        case ItemType::DOOR: {
-            idx = sheet_0::door;
-            WallType wall_type = this->get_wall_type(position);
-            if (wall_type == WallType::VERTICAL) idx += 1;
-        } break;
-        case ItemType::NONE: {
-        } break;
-    }
-
-    return idx;
-}
-
 }  // namespace the_shell
@@ -1,39 +1,34 @@
 #pragma once
 
+#include "core/impostor_atlas.hpp"
 #include "core/renderer.hpp"
 #include "core/resources.hpp"
-#include "entt/entity/entity.hpp"
+#include "core/thread_pool.hpp"
 #include "entt/entity/fwd.hpp"
-#include "entt/entt.hpp"
+#include "input_stream.hpp"
+#include "world.hpp"
 #include <array>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace the_shell {
 // -----------------------------------------------------------------------
 // constants
-static constexpr uint32_t grid_n_rows = 100;
-static constexpr uint32_t grid_n_cols = 100;
-static const float door_open_dist = 2.0;
+static const char *const save_file_path = "save.tsgf";
 
-// -----------------------------------------------------------------------
-// sheet indexes
-namespace sheet_0 {
-static constexpr uint32_t wall = 1;
-static constexpr uint32_t door = 17;
-}  // namespace sheet_0
+// Mouse wheel zoom, in cells across the screen, by a factor per notch
+static const float min_view_width = 8.0;
+static const float max_view_width = 320.0;
+static const float zoom_step = 1.15;
 
-// -----------------------------------------------------------------------
-// enums
-enum class WallType {
-    NONE,
-    HORIZONTAL,
-    VERTICAL,
-};
-
-enum class ItemType {
-    NONE,
-    WALL,
-    DOOR,
-};
+// Below this many pixels per cell the grid layers are drawn as chunk
+// impostors, rendered at impostor_px_per_cell. A view zoomed out all the
+// way takes about 250 chunks per layer, the atlas holds 1024
+static const float impostor_lod_px_per_cell = 8.0;
+static constexpr uint32_t impostor_px_per_cell = 4;
+static constexpr uint32_t impostor_atlas_size = 2048;
+static constexpr uint32_t max_impostor_redraws = 32;  // per frame
 
 // -----------------------------------------------------------------------
 // camera
@@ -46,46 +41,21 @@ public:
 };
 
 // -----------------------------------------------------------------------
-// item
-class Item {
-public:
-    entt::entity entity = entt::null;
-    ItemType type = ItemType::NONE;
-    Sprite sprite;
-
-    Item();
-    Item(ItemType type, Sprite sprite);
-
-    bool is_none();
-    bool is_wall();
-    bool is_door();
-    bool is_wall_or_door();
+// chunk batches
+// Render cache of one grid layer chunk: what its non-empty cells draw as
+// of the chunk version, rebuilt once the version moves
+struct ChunkBatch {
+    uint32_t version = 0;
+    std::vector<Renderable> renderables;
+    std::vector<Vector2> positions;
 };
 
 // -----------------------------------------------------------------------
-// cell
-class Cell {
-private:
-    Vector2 position;
-
-public:
-    Item item;
-
-    Cell();
-    Cell(Vector2 position);
+// components
+struct Renderable_C : public Renderable {};
 
-    Vector2 get_position();
-    Rectangle get_rect();
-};
-
-class CellNeighbors {
-public:
-    std::array<Cell *, 8> cells;
-
-    CellNeighbors();
-
-    std::array<Cell *, 4> get_orthos();
-};
+// Draws every entity with Renderable_C and Position_C
+void draw_renderables(Renderer &renderer, entt::registry &registry);
 
 // -----------------------------------------------------------------------
 // game
@@ -93,55 +63,57 @@ class Game {
 private:
     Renderer renderer;
     Resources resources;
+    ImpostorAtlas impostor_atlas;
 
     Camera camera;
 
-    // -------------------------------------------------------------------
-    // grid
-    std::array<Cell, grid_n_rows * grid_n_cols> cells;
+    ThreadPool thread_pool;
+    World world;
 
-    // -------------------------------------------------------------------
-    // inventory
-    int active_item_idx = -1;
-    std::vector<Item> items;
+    // Per GridLayer and tile chunk. The walls' are only built for the
+    // impostors: with static sprites, their animations aren't tracked by
+    // the versions. Hidden roofs keep theirs, showing them again doesn't
+    // rebuild anything
+    std::array<std::vector<ChunkBatch>, n_grid_layers> chunk_batches;
+    bool is_roof_visible = true;
 
     // -------------------------------------------------------------------
     // inputs
-    float dt;
+    Input input;
 
-    Vector2 mouse_position_world;
     Vector2 mouse_position_screen;
     Vector2 mouse_position_grid;
 
+    // World region on screen
+    Rectangle view_rect = {0.0, 0.0, 0.0, 0.0};
+
     bool is_lmb_pressed;
     bool is_lmb_released;
-    bool is_lmb_down;
-    bool is_ui_interacted;
-
-    bool is_w_down;
-    bool is_s_down;
-    bool is_a_down;
-    bool is_d_down;
 
-    // -------------------------------------------------------------------
-    // entities
-    entt::registry registry;
-    entt::entity player;
+    std::unique_ptr<InputRecorder> input_recorder;
 
     // -------------------------------------------------------------------
     // update
     void update();
     void update_input();
-    void update_active_item_placement();
-    void update_player();
-    void update_doors();
-    void update_collisions();
 
     // -------------------------------------------------------------------
     // draw
     void draw();
-    void draw_renderables();
+    void draw_lights();
     void draw_grid_items();
+    void draw_layer(GridLayer layer);
+    void draw_layer_impostors(GridLayer layer);
+    void update_impostors();
+    bool is_impostor_lod();
+    bool is_layer_drawn(GridLayer layer);
+    bool get_view_chunks(CellRect &chunks);
+    uint32_t get_chunk_version(GridLayer layer, uint32_t chunk_row, uint32_t chunk_col);
+    ChunkBatch &get_chunk_batch(GridLayer layer, uint32_t chunk_row, uint32_t chunk_col);
+    void build_chunk_batch(
+        GridLayer layer, uint32_t chunk_row, uint32_t chunk_col, ChunkBatch &batch
+    );
+    void draw_chunk_batch(const ChunkBatch &batch);
     void draw_active_item_ghost();
     void update_and_draw_quickbar();
 
@@ -151,18 +123,11 @@ private:
     void set_active_item(int item_idx);
     void clear_active_item();
 
-    Rectangle get_world_rect();
-    Rectangle get_occupied_rect(Vector2 position);
-    Cell *get_cell(Vector2 position);
-    CellNeighbors get_cell_neighbors(Vector2 position);
-    WallType get_wall_type(Vector2 position);
-    Vector2 round_position(Vector2 position);
-    bool can_place_item(const Item *item, Vector2 position);
-    bool place_item(const Item *item, Vector2 position);
-    uint32_t suggest_item_sprite_idx(Vector2 position, ItemType item_type);
-
 public:
     Game();
     void run();
+
+    // Logs the input of every following tick to the file
+    void record_input(std::string file_path);
 };
 }  // namespace the_shell
@@ -0,0 +1,128 @@
+#include "input_stream.hpp"
+
+#include "world.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace the_shell {
+static constexpr uint32_t magic = 0x4e495354;  // "TSIN"
+static constexpr uint32_t version = 1;
+
+enum InputField : uint8_t {
+    DT = 1 << 0,
+    MOUSE = 1 << 1,
+    BUTTONS = 1 << 2,
+    ACTIVE_ITEM = 1 << 3,
+};
+
+static uint8_t get_buttons(const Input &input) {
+    return input.is_lmb_down << 0 | input.is_ui_interacted << 1 | input.is_w_down << 2
+           | input.is_s_down << 3 | input.is_a_down << 4 | input.is_d_down << 5
+           | input.is_undo_pressed << 6 | input.is_redo_pressed << 7;
+}
+
+static void set_buttons(Input &input, uint8_t buttons) {
+    input.is_lmb_down = buttons & 1 << 0;
+    input.is_ui_interacted = buttons & 1 << 1;
+    input.is_w_down = buttons & 1 << 2;
+    input.is_s_down = buttons & 1 << 3;
+    input.is_a_down = buttons & 1 << 4;
+    input.is_d_down = buttons & 1 << 5;
+    input.is_undo_pressed = buttons & 1 << 6;
+    input.is_redo_pressed = buttons & 1 << 7;
+}
+
+// -----------------------------------------------------------------------
+// recorder
+InputRecorder::InputRecorder(std::string file_path)
+    : file(file_path, std::ios::binary) {
+    if (!this->file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path);
+    }
+
+    this->file.write((const char *)&magic, sizeof(magic));
+    this->file.write((const char *)&version, sizeof(version));
+}
+
+void InputRecorder::record(const Input &input) {
+    const Input &prev = this->prev_input;
+    uint8_t mask = 0;
+    if (std::memcmp(&input.dt, &prev.dt, sizeof(float))) mask |= DT;
+    if (std::memcmp(
+            &input.mouse_position_world, &prev.mouse_position_world, sizeof(Vector2)
+        )) {
+        mask |= MOUSE;
+    }
+    if (get_buttons(input) != get_buttons(prev)) mask |= BUTTONS;
+    if (input.active_item_idx != prev.active_item_idx) mask |= ACTIVE_ITEM;
+
+    this->file.put(mask);
+    if (mask & DT) this->file.write((const char *)&input.dt, sizeof(float));
+    if (mask & MOUSE) {
+        this->file.write((const char *)&input.mouse_position_world.x, sizeof(float));
+        this->file.write((const char *)&input.mouse_position_world.y, sizeof(float));
+    }
+    if (mask & BUTTONS) this->file.put(get_buttons(input));
+    if (mask & ACTIVE_ITEM) {
+        int32_t active_item_idx = input.active_item_idx;
+        this->file.write((const char *)&active_item_idx, sizeof(int32_t));
+    }
+
+    this->prev_input = input;
+}
+
+// -----------------------------------------------------------------------
+// replay
+InputReplay::InputReplay(std::string file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path);
+    }
+    this->data.assign(std::istreambuf_iterator<char>(file), {});
+
+    uint32_t header[2] = {0, 0};
+    if (this->data.size() >= sizeof(header)) {
+        std::memcpy(header, this->data.data(), sizeof(header));
+    }
+    if (header[0] != magic || header[1] != version) {
+        throw std::runtime_error("Invalid input log: " + file_path);
+    }
+    this->pos = sizeof(header);
+}
+
+bool InputReplay::next(Input &input) {
+    if (this->pos >= this->data.size()) return false;
+
+    uint8_t mask = this->data[this->pos++];
+    size_t size = (mask & DT ? 4 : 0) + (mask & MOUSE ? 8 : 0)
+                  + (mask & BUTTONS ? 1 : 0) + (mask & ACTIVE_ITEM ? 4 : 0);
+    if (this->pos + size > this->data.size()) {
+        throw std::runtime_error("Truncated input log");
+    }
+
+    auto read = [&](void *value, size_t size) {
+        std::memcpy(value, &this->data[this->pos], size);
+        this->pos += size;
+    };
+    if (mask & DT) read(&this->input.dt, sizeof(float));
+    if (mask & MOUSE) {
+        read(&this->input.mouse_position_world.x, sizeof(float));
+        read(&this->input.mouse_position_world.y, sizeof(float));
+    }
+    if (mask & BUTTONS) set_buttons(this->input, this->data[this->pos++]);
+    if (mask & ACTIVE_ITEM) {
+        int32_t active_item_idx;
+        read(&active_item_idx, sizeof(int32_t));
+        this->input.active_item_idx = active_item_idx;
+    }
+
+    input = this->input;
+    return true;
+}
+}  // namespace the_shell
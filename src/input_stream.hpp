@@ -0,0 +1,41 @@
+#pragma once
+
+#include "world.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace the_shell {
+// Per-tick Input log. Every tick starts with a mask byte of the fields
+// which changed since the previous tick, followed by these fields only
+// (floats are stored bit-exact), so a replay feeds the world exactly the
+// same inputs. World changes made outside of World::update (e.g. loads)
+// aren't part of the log.
+class InputRecorder {
+private:
+    std::ofstream file;
+    Input prev_input;
+
+public:
+    // Throws if the file can't be opened
+    explicit InputRecorder(std::string file_path);
+
+    void record(const Input &input);
+};
+
+class InputReplay {
+private:
+    std::vector<uint8_t> data;
+    size_t pos = 0;
+    Input input;
+
+public:
+    // Throws if the file can't be read or isn't an input log
+    explicit InputReplay(std::string file_path);
+
+    // Input of the next tick, false once the log is over
+    bool next(Input &input);
+};
+}  // namespace the_shell
@@ -1,8 +1,10 @@
 #include "game.hpp"
+#include <string>
 
-int main() {
+int main(int argc, char **argv) {
     SetTraceLogLevel(LOG_DEBUG);
 
     the_shell::Game game;
+    if (argc == 3 && std::string(argv[1]) == "--record") game.record_input(argv[2]);
     game.run();
 }
@@ -0,0 +1,1218 @@
+#include "world.hpp"
+
+#include "core/animation.hpp"
+#include "core/geometry.hpp"
+#include "core/grid_file.hpp"
+#include "core/wall_segments.hpp"
+#include "json.hpp"
+#include "raylib.h"
+#include "raymath.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace the_shell {
+// -----------------------------------------------------------------------
+// item
+Item::Item() = default;
+
+Item::Item(ItemType type, uint32_t sprite_idx)
+    : type(type)
+    , sprite_idx(sprite_idx) {}
+
+bool Item::is_none() {
+    return this->type == ItemType::NONE;
+}
+
+bool Item::is_wall() {
+    return this->type == ItemType::WALL;
+}
+
+bool Item::is_door() {
+    return this->type == ItemType::DOOR;
+}
+
+bool Item::is_wall_or_door() {
+    return this->is_wall() || this->is_door();
+}
+
+GridLayer get_item_layer(ItemType item_type) {
+    switch (item_type) {
+        case ItemType::FLOOR: return GridLayer::FLOOR;
+        case ItemType::ROOF: return GridLayer::ROOF;
+        case ItemType::ZONE: return GridLayer::OVERLAY;
+        default: return GridLayer::WALL;
+    }
+}
+
+// -----------------------------------------------------------------------
+// cell
+uint64_t CellCoord::get_key() const {
+    return ((uint64_t)(uint32_t)this->row << 32) | (uint32_t)this->col;
+}
+
+void CellEntityIndex::insert(CellCoord coord, entt::entity entity) {
+    this->entities.insert_or_assign(coord.get_key(), entity);
+}
+
+void CellEntityIndex::erase(CellCoord coord) {
+    this->entities.erase(coord.get_key());
+}
+
+entt::entity CellEntityIndex::get(CellCoord coord) const {
+    auto it = this->entities.find(coord.get_key());
+    return it == this->entities.end() ? entt::null : it->second;
+}
+
+CellNeighbors::CellNeighbors() {
+    this->cells.fill(nullptr);
+}
+
+std::array<Cell *, 4> CellNeighbors::get_orthos() {
+    return {cells[0], cells[2], cells[4], cells[6]};
+}
+
+// -----------------------------------------------------------------------
+// parallel view iteration
+template <typename View, typename Func>
+static void parallel_each(ThreadPool &pool, View view, Func func) {
+    auto *handle = view.handle();
+    if (!handle) return;
+
+    pool.parallel_for(
+        handle->size(),
+        min_system_chunk_size,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                entt::entity entity = (*handle)[i];
+                if (view.contains(entity)) func(entity);
+            }
+        }
+    );
+}
+
+// -----------------------------------------------------------------------
+// autotiling
+// Orientation of the wall or door on the cell from its orthogonal
+// neighbors, in the von Neumann order
+static WallType get_cell_wall_type(Cell *cell, const std::array<Cell *, 4> &orthos) {
+    if (!cell || !cell->item.is_wall_or_door()) return WallType::NONE;
+
+    bool walls[4];
+    for (int i = 0; i < 4; ++i) {
+        walls[i] = orthos[i] && orthos[i]->item.is_wall_or_door();
+    }
+
+    bool is_horizontal = walls[0] || walls[2];
+    bool is_vertical = walls[1] || walls[3];
+
+    if (is_horizontal && !is_vertical) return WallType::HORIZONTAL;
+    if (!is_horizontal && is_vertical) return WallType::VERTICAL;
+    return WallType::NONE;
+}
+
+// Sprite of the item on the cell (which may hold another item yet) from
+// the cell's orthogonal neighbors, in the von Neumann order
+static uint32_t get_item_sprite_idx(
+    ItemType item_type, Cell *cell, const std::array<Cell *, 4> &orthos
+) {
+    uint8_t idx = 0;
+
+    switch (item_type) {
+        case ItemType::WALL: {
+            idx = sheet_0::wall;
+            for (int i = 0; i < 4; ++i) {
+                Cell *ortho = orthos[i];
+                if (ortho && ortho->item.is_wall_or_door()) {
+                    idx += 1 << (4 - i - 1);
+                }
+            }
+        } break;
+        case ItemType::DOOR: {
+            idx = sheet_0::door;
+            WallType wall_type = get_cell_wall_type(cell, orthos);
+            if (wall_type == WallType::VERTICAL) idx += 1;
+        } break;
+        // The tile layers are drawn without sprites
+        case ItemType::FLOOR:
+        case ItemType::ROOF:
+        case ItemType::ZONE:
+        case ItemType::NONE: {
+        } break;
+    }
+
+    return idx;
+}
+
+// -----------------------------------------------------------------------
+// grid change subscribers
+template <typename Func>
+void World::subscribe_cell_changes(Func func) {
+    this->cell_changes.subscribe([this, func](const std::vector<CellRect> &rects) {
+        for (const CellRect &rect : rects) {
+            for (int32_t row = rect.row0; row <= rect.row1; ++row) {
+                for (int32_t col = rect.col0; col <= rect.col1; ++col) {
+                    CellCoord coord = {.row = row, .col = col};
+                    uint32_t idx = this->get_cell_idx(coord);
+                    func(coord, idx, this->cells[idx].item);
+                }
+            }
+        }
+    });
+}
+
+// -----------------------------------------------------------------------
+// world
+World::World(
+    uint32_t n_rows,
+    uint32_t n_cols,
+    ThreadPool &thread_pool,
+    AnimationTable &animation_table
+)
+    : thread_pool(thread_pool)
+    , animation_table(animation_table)
+    , journal(max_journal_n_bytes)
+    , n_rows(n_rows)
+    , n_cols(n_cols)
+    , cell_changes(n_rows, n_cols, change_chunk_size)
+    , opaque_cells(n_rows, n_cols)
+    , wall_segments(n_rows, n_cols, {this->get_world_rect().x, this->get_world_rect().y})
+    , wall_colliders(
+          n_rows,
+          n_cols,
+          collision_chunk_size,
+          {this->get_world_rect().x, this->get_world_rect().y}
+      )
+    , wall_distances(
+          n_rows,
+          n_cols,
+          distance_chunk_size,
+          max_wall_dist,
+          {this->get_world_rect().x, this->get_world_rect().y}
+      )
+    , rooms(n_rows, n_cols)
+    , floor_layer(n_rows, n_cols, tile_chunk_size)
+    , roof_layer(n_rows, n_cols, tile_chunk_size)
+    , overlay_layer(n_rows, n_cols, tile_chunk_size)
+    , flow_fields(n_rows, n_cols, max_n_flow_fields)
+    , path_graph(n_rows, n_cols, nav_cluster_size, nav_door_cost) {
+
+    // -------------------------------------------------------------------
+    // inventory
+    this->items.emplace_back(ItemType::WALL, sheet_0::wall);
+    this->items.emplace_back(ItemType::DOOR, sheet_0::door);
+    this->items.emplace_back(ItemType::FLOOR, 0);
+    this->items.emplace_back(ItemType::ROOF, 0);
+    this->items.emplace_back(ItemType::ZONE, 0);
+
+    // -------------------------------------------------------------------
+    // animations
+    this->door_clips = {
+        .horizontal_closed = animation_table.get_clip_idx("door_horizontal_closed"),
+        .horizontal_open = animation_table.get_clip_idx("door_horizontal_open"),
+        .vertical_closed = animation_table.get_clip_idx("door_vertical_closed"),
+        .vertical_open = animation_table.get_clip_idx("door_vertical_open")};
+
+    // -------------------------------------------------------------------
+    // systems
+    // Storages are created upfront: systems run concurrently and must not
+    // insert new pools into the registry while others look them up
+    this->registry.storage<Position_C>();
+    this->registry.storage<ResolveCollision_C>();
+    this->registry.storage<Door_C>();
+    this->registry.storage<Animation_C>();
+    this->registry.storage<Cell_C>();
+    this->registry.storage<FollowFlow_C>();
+    this->registry.storage<Vision_C>();
+    this->registry.storage<Light_C>();
+
+    // The grid itself is declared as the `Cell` resource, the other layers
+    // as `TileLayer` and the wall sprite versions as `WallChunkVersions`.
+    // Placements only flag their chunks, the flush of grid_changes publishes
+    // the tile versions and autotiles, which bumps the wall versions
+    // clang-format off
+    this->scheduler.add_system<
+        &World::update_active_item_placement,
+        const Position_C, const ResolveCollision_C,
+        Door_C, Animation_C, Cell_C, Cell, GridChanges, TileLayer
+    >(*this, "active_item_placement");
+    this->scheduler.add_system<
+        &World::update_grid_changes,
+        const Door_C, const Cell_C, const Animation_C,
+        Cell, GridChanges, TileLayer, WallChunkVersions, GridMask, WallSegments,
+        CollisionLayer, DistanceField, RoomGraph, FlowFieldCache, PathGraph
+    >(*this, "grid_changes");
+    this->scheduler.add_system<
+        &World::update_player,
+        Position_C
+    >(*this, "player");
+    this->scheduler.add_system<
+        &World::update_path_graph,
+        PathGraph
+    >(*this, "path_graph");
+    this->scheduler.add_system<
+        &World::update_flow_fields,
+        const FollowFlow_C, FlowFieldCache
+    >(*this, "flow_fields");
+    this->scheduler.add_system<
+        &World::update_flow_followers,
+        const FollowFlow_C, const FlowFieldCache, Position_C
+    >(*this, "flow_followers");
+    this->scheduler.add_system<
+        &World::update_visions,
+        const Position_C, const GridMask, Vision_C
+    >(*this, "visions");
+    this->scheduler.add_system<
+        &World::update_doors,
+        const Position_C, const Door_C, const Cell_C, const Cell, Animation_C
+    >(*this, "doors");
+    this->scheduler.add_system<
+        &World::update_lights,
+        const Position_C, const Door_C, const Cell_C, const Animation_C,
+        WallSegments, Light_C
+    >(*this, "lights");
+    this->scheduler.add_system<
+        &World::update_animations,
+        const Animation_C, const Cell_C, Cell
+    >(*this, "animations");
+    this->scheduler.add_system<
+        &World::update_wall_colliders,
+        CollisionLayer
+    >(*this, "wall_colliders");
+    this->scheduler.add_system<
+        &World::update_wall_distances,
+        const Door_C, const Cell_C, const Animation_C, DistanceField
+    >(*this, "wall_distances");
+    this->scheduler.add_system<
+        &World::update_collisions,
+        const ResolveCollision_C, const Cell, const CollisionLayer, const DistanceField,
+        Position_C
+    >(*this, "collisions");
+    // clang-format on
+
+    // -------------------------------------------------------------------
+    // entities
+    this->player = this->registry.create();
+    this->registry.emplace<Position_C>(this->player, Position_C({0.0, 0.0}));
+    this->registry.emplace<ResolveCollision_C>(this->player);
+
+    // -------------------------------------------------------------------
+    // grid
+    uint32_t n_tile_chunks = this->floor_layer.get_n_chunk_rows()
+                             * this->floor_layer.get_n_chunk_cols();
+    this->wall_chunk_versions.resize(n_tile_chunks, 1);
+    this->cells.resize(n_rows * n_cols);
+
+    // -------------------------------------------------------------------
+    // grid changes
+    // One subscriber per derived grid, large flushes run them concurrently.
+    // The autotiling only writes the sprites, the others read the types.
+    // The tile layers only publish their versions
+    this->subscribe_cell_changes([this](CellCoord, uint32_t idx, Item &item) {
+        this->flow_fields.set_terrain(idx, this->get_item_terrain(item.type));
+    });
+    this->subscribe_cell_changes([this](CellCoord, uint32_t idx, Item &item) {
+        this->path_graph.set_terrain(idx, this->get_item_terrain(item.type));
+    });
+    this->subscribe_cell_changes([this](CellCoord, uint32_t idx, Item &item) {
+        this->rooms.set_terrain(idx, this->get_item_terrain(item.type));
+    });
+    this->subscribe_cell_changes([this](CellCoord coord, uint32_t, Item &item) {
+        this->opaque_cells.set(coord.row, coord.col, item.is_wall_or_door());
+    });
+    this->subscribe_cell_changes([this](CellCoord coord, uint32_t, Item &item) {
+        this->wall_colliders.set_solid(coord.row, coord.col, item.is_wall());
+    });
+    this->subscribe_cell_changes([this](CellCoord coord, uint32_t, Item &item) {
+        bool is_occluder = this->is_cell_occluder(coord, item);
+        this->wall_segments.set_occluder(coord.row, coord.col, is_occluder);
+    });
+    this->subscribe_cell_changes([this](CellCoord coord, uint32_t, Item &item) {
+        bool is_occluder = this->is_cell_occluder(coord, item);
+        this->wall_distances.set_solid(coord.row, coord.col, is_occluder);
+    });
+    this->cell_changes.subscribe([this](const std::vector<CellRect> &rects) {
+        for (const CellRect &rect : rects) this->autotile(rect);
+    });
+    for (TileLayer *tiles :
+         {&this->floor_layer, &this->roof_layer, &this->overlay_layer}) {
+        this->cell_changes.subscribe([tiles](const std::vector<CellRect> &rects) {
+            for (const CellRect &rect : rects) {
+                tiles->publish_changes(rect.row0, rect.col0, rect.row1, rect.col1);
+            }
+        });
+    }
+}
+
+// -----------------------------------------------------------------------
+// update
+void World::update(const Input &input) {
+    this->input = input;
+    this->time += input.dt;
+
+    // Keep the door pools in the grid order, so the door systems walk the
+    // cells (mostly) sequentially. Sorted once per tick, not per placement
+    if (!this->is_cell_pool_sorted) {
+        this->registry.sort<Cell_C>([](const Cell_C &lhs, const Cell_C &rhs) {
+            return lhs.get_key() < rhs.get_key();
+        });
+        this->registry.sort<Animation_C, Cell_C>();
+        this->is_cell_pool_sorted = true;
+    }
+
+    this->scheduler.run(this->registry, this->thread_pool);
+}
+
+std::vector<SystemTiming> World::get_system_timings() {
+    return this->scheduler.get_timings();
+}
+
+void World::update_active_item_placement() {
+    Vector2 mouse_position = this->round_position(this->input.mouse_position_world);
+
+    Item *item = this->get_item(this->input.active_item_idx);
+    Cell *cell = this->get_cell(mouse_position);
+
+    if (this->input.is_undo_pressed) this->undo();
+    if (this->input.is_redo_pressed) this->redo();
+
+    // The stroke is one action, committed once the button is released
+    bool was_dragging = this->is_dragging;
+    this->is_dragging = false;
+    if (was_dragging && !this->input.is_lmb_down) this->commit_edits();
+    if (!item) return;
+    if (!cell) return;
+    if (this->input.is_ui_interacted) return;
+    if (!this->input.is_lmb_down) return;
+
+    // Fast drags move the cursor over several cells per tick, the stroke
+    // covers every cell between the last and the current one
+    CellCoord coord = this->get_cell_coord(mouse_position);
+    CellCoord start = was_dragging ? this->drag_coord : coord;
+    this->drag_coord = coord;
+    this->is_dragging = true;
+
+    this->place_items(item, this->get_line_coords(start, coord));
+}
+
+void World::update_grid_changes() {
+    // Whatever this tick's placements (and the writes since the last tick)
+    // changed, in one pass
+    this->flush_changes();
+}
+
+void World::update_player() {
+    static float speed = 3.0;
+
+    auto &position = registry.get<Position_C>(this->player);
+    Vector2 step = Vector2Zero();
+    if (this->input.is_w_down) step.y -= 1.0;
+    if (this->input.is_s_down) step.y += 1.0;
+    if (this->input.is_a_down) step.x -= 1.0;
+    if (this->input.is_d_down) step.x += 1.0;
+
+    step = Vector2Scale(Vector2Normalize(step), this->input.dt * speed);
+    position = Position_C(Vector2Add(step, position));
+}
+
+void World::update_path_graph() {
+    // Rebuilds the clusters touched by this tick's placements, so the
+    // queries don't pay for it
+    this->path_graph.update();
+}
+
+void World::update_flow_fields() {
+    // Repairs the cached fields after this tick's placements and makes sure
+    // every goal in use has a field before the followers sample them
+    this->flow_fields.update();
+
+    auto view = registry.view<FollowFlow_C>();
+    for (auto entity : view) {
+        auto [follow] = view.get(entity);
+        if (!this->is_in_grid(follow.goal)) continue;
+
+        float door_cost = follow.can_open_doors ? nav_door_cost : -1.0f;
+        this->flow_fields.get_field(this->get_cell_idx(follow.goal), door_cost);
+    }
+}
+
+void World::update_flow_followers() {
+    float dt = this->input.dt;
+
+    auto view = registry.view<Position_C, FollowFlow_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        auto [position, follow] = view.get(entity);
+
+        CellCoord coord = this->get_cell_coord(position);
+        if (!this->is_in_grid(coord)) return;
+
+        float door_cost = follow.can_open_doors ? nav_door_cost : -1.0f;
+        const FlowField *field = this->flow_fields.find_field(
+            this->get_cell_idx(follow.goal), door_cost
+        );
+        if (!field) return;
+
+        Vector2 dir = field->get_direction(this->get_cell_idx(coord));
+        position = Position_C(Vector2Add(position, Vector2Scale(dir, follow.speed * dt)));
+    });
+}
+
+void World::update_visions() {
+    auto view = registry.view<Position_C, Vision_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        auto [position, vision] = view.get(entity);
+        CellCoord coord = this->get_cell_coord(position);
+        vision.fov.compute(this->opaque_cells, coord.row, coord.col, vision.radius);
+    });
+}
+
+void World::update_doors() {
+    auto player_position = registry.get<Position_C>(this->player);
+
+    auto view = registry.view<Cell_C, Door_C, Animation_C>();
+    view.use<Cell_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        auto [coord, animation] = view.get<Cell_C, Animation_C>(entity);
+        Vector2 cell_position = this->get_cell_position(coord);
+        bool is_vertical = this->get_wall_type(coord) == WallType::VERTICAL;
+        bool is_open = Vector2Distance(player_position, cell_position) <= door_open_dist;
+
+        uint32_t clip_idx;
+        if (is_vertical) {
+            clip_idx = is_open ? door_clips.vertical_open : door_clips.vertical_closed;
+        } else {
+            clip_idx = is_open ? door_clips.horizontal_open
+                               : door_clips.horizontal_closed;
+        }
+
+        if (animation.clip_idx != clip_idx) {
+            animation = {.clip_idx = clip_idx, .start_time = this->time};
+        }
+    });
+}
+
+void World::update_lights() {
+    // Closed doors occlude, the state is the one the doors system has just
+    // picked. Unchanged cells don't dirty the segments
+    auto doors = registry.view<Cell_C, Door_C, Animation_C>();
+    for (auto entity : doors) {
+        auto [coord, animation] = doors.get<Cell_C, Animation_C>(entity);
+        this->wall_segments.set_occluder(
+            coord.row, coord.col, !this->is_door_open(animation)
+        );
+    }
+    this->wall_segments.update();
+
+    auto view = registry.view<Position_C, Light_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        static thread_local std::vector<Segment> segments;
+        auto [position, light] = view.get(entity);
+
+        Rectangle rect = {
+            .x = position.x - light.radius,
+            .y = position.y - light.radius,
+            .width = 2.0f * light.radius,
+            .height = 2.0f * light.radius};
+        segments.clear();
+        this->wall_segments.query(rect, segments);
+        get_visibility_polygon(position, light.radius, segments, light.polygon);
+    });
+}
+
+void World::update_animations() {
+    // Single pass over the packed Animation_C pool: the frame index is a
+    // function of the clip and the clip start time only
+    AnimationTable &animations = this->animation_table;
+
+    auto view = registry.view<Animation_C, Cell_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        auto [animation, coord] = view.get(entity);
+        Cell *cell = this->get_cell(coord);
+        if (!cell) return;
+        cell->item.sprite_idx = animations.get_frame_idx(
+            animation.clip_idx, this->time - animation.start_time
+        );
+    });
+}
+
+void World::update_wall_colliders() {
+    // Re-meshes the chunks touched by this tick's placements
+    this->wall_colliders.update();
+}
+
+void World::update_wall_distances() {
+    // Same door states as the light occluders, unchanged cells don't dirty
+    // the chunks
+    auto doors = registry.view<Cell_C, Door_C, Animation_C>();
+    for (auto entity : doors) {
+        auto [coord, animation] = doors.get<Cell_C, Animation_C>(entity);
+        this->wall_distances.set_solid(
+            coord.row, coord.col, !this->is_door_open(animation)
+        );
+    }
+    this->wall_distances.update();
+}
+
+void World::update_collisions() {
+    auto player_position = registry.get<Position_C>(this->player);
+
+    auto view = registry.view<Position_C, ResolveCollision_C>();
+    parallel_each(this->thread_pool, view, [&](entt::entity entity) {
+        auto [position] = view.get(entity);
+
+        // Nothing solid within the body radius (0.5), the sampled distance
+        // overshoots the exact one by less than half a cell
+        if (this->wall_distances.get_distance(position) > 1.0f) return;
+
+        // Walls: the few merged rects around the body, the seams between
+        // them (the chunk borders among others) don't push it sideways
+        static thread_local std::vector<Rectangle> rects;
+        rects.clear();
+        Rectangle body_rect = {
+            .x = position.x - 0.5f, .y = position.y - 0.5f, .width = 1.0, .height = 1.0
+        };
+        this->wall_colliders.query(body_rect, rects);
+        position = Vector2Add(position, get_circle_rects_mtv(position, 0.5, rects));
+
+        // Doors: per cell, they're passable while the player is near
+        CellCoord coord = this->get_cell_coord(position);
+        CellNeighbors nb = this->get_cell_neighbors(position);
+        for (uint32_t i = 0; i < nb.cells.size(); ++i) {
+            Cell *cell = nb.cells[i];
+            if (!cell || !cell->item.is_door()) continue;
+
+            Vector2 cell_position = this->get_cell_position(
+                {.row = coord.row + stencils::moore.d_rows[i],
+                 .col = coord.col + stencils::moore.d_cols[i]}
+            );
+            if (Vector2Distance(player_position, cell_position) <= door_open_dist) {
+                continue;
+            }
+
+            Rectangle rect = {
+                .x = cell_position.x - 0.5f,
+                .y = cell_position.y - 0.5f,
+                .width = 1.0,
+                .height = 1.0};
+            Vector2 mtv = get_circle_rect_mtv(position, 0.5, rect);
+            position = Vector2Add(position, mtv);
+        }
+    });
+}
+
+// -----------------------------------------------------------------------
+// other
+Item *World::get_item(int item_idx) {
+    if (item_idx >= 0 && (uint32_t)item_idx < this->items.size()) {
+        return &this->items[item_idx];
+    }
+
+    return nullptr;
+}
+
+Rectangle World::get_world_rect() {
+    return {
+        .x = -(float)this->n_cols / 2.0f,
+        .y = -(float)this->n_rows / 2.0f,
+        .width = (float)this->n_cols,
+        .height = (float)this->n_rows
+    };
+}
+
+CellCoord World::get_cell_coord(Vector2 position) {
+    Rectangle world_rect = this->get_world_rect();
+    int32_t col = std::floor(position.x - world_rect.x);
+    int32_t row = std::floor(position.y - world_rect.y);
+    return {.row = row, .col = col};
+}
+
+Vector2 World::get_cell_position(CellCoord coord) {
+    Rectangle world_rect = this->get_world_rect();
+    float x = world_rect.x + (float)coord.col + 0.5;
+    float y = world_rect.y + (float)coord.row + 0.5;
+    return {x, y};
+}
+
+bool World::is_in_grid(CellCoord coord) {
+    return (uint32_t)coord.row < this->n_rows && (uint32_t)coord.col < this->n_cols;
+}
+
+Cell *World::get_cell(CellCoord coord) {
+    if (!this->is_in_grid(coord)) return nullptr;
+
+    return &this->cells[this->get_cell_idx(coord)];
+}
+
+uint32_t World::get_cell_idx(CellCoord coord) {
+    return coord.row * this->n_cols + coord.col;
+}
+
+Cell *World::get_cell(Vector2 position) {
+    return this->get_cell(this->get_cell_coord(position));
+}
+
+GridView<Cell> World::get_cell_view() {
+    return GridView<Cell>(this->cells.data(), this->n_rows, this->n_cols);
+}
+
+CellNeighbors World::get_cell_neighbors(Vector2 position) {
+    CellNeighbors nb;
+
+    CellCoord c = this->get_cell_coord(position);
+    GridView<Cell> view = this->get_cell_view();
+    if (view.contains(c.row, c.col)) {
+        nb.cells = view.gather(c.row, c.col, stencils::moore);
+    }
+
+    return nb;
+}
+
+Rectangle World::get_occupied_rect(Vector2 position) {
+    float left_x = std::floor(position.x - 0.5);
+    float right_x = std::ceil(position.x + 0.5);
+    float top_y = std::floor(position.y - 0.5);
+    float bot_y = std::ceil(position.y + 0.5);
+    float width = right_x - left_x;
+    float height = bot_y - top_y;
+
+    return {.x = left_x, .y = top_y, .width = width, .height = height};
+}
+
+WallType World::get_wall_type(CellCoord coord) {
+    GridView<Cell> view = this->get_cell_view();
+    Cell *mid = view.get(coord.row, coord.col);
+    if (!mid) return WallType::NONE;
+
+    return get_cell_wall_type(
+        mid, view.gather(coord.row, coord.col, stencils::von_neumann)
+    );
+}
+
+WallType World::get_wall_type(Vector2 position) {
+    return this->get_wall_type(this->get_cell_coord(position));
+}
+
+Vector2 World::round_position(Vector2 position) {
+    float x = std::floor(position.x) + 0.5;
+    float y = std::floor(position.y) + 0.5;
+    return {x, y};
+}
+
+bool World::can_place_item(const Item *item, Vector2 position) {
+    static float build_radius = 4.0;
+
+    Cell *cell = this->get_cell(position);
+    if (!item) return false;
+    if (!cell) return false;
+
+    auto player_position = registry.get<Position_C>(this->player);
+    if (Vector2Distance(position, player_position) > build_radius) {
+        return false;
+    }
+
+    // Tiles go on any cell where their layer is free, the bodies only
+    // block the walls and doors
+    GridLayer layer = get_item_layer(item->type);
+    if (layer != GridLayer::WALL) {
+        CellCoord coord = this->get_cell_coord(position);
+        return this->get_layer_item_type(coord, layer) == ItemType::NONE;
+    }
+
+    auto view = registry.view<Position_C, ResolveCollision_C>();
+    for (auto entity : view) {
+        auto [e_pos] = view.get(entity);
+        Rectangle rect = this->get_occupied_rect(e_pos);
+        if (check_point_in_rect(position, rect)) {
+            return false;
+        }
+    }
+
+    switch (item->type) {
+        case ItemType::WALL: {
+            if (cell->item.type != ItemType::NONE) return false;
+            CellCoord coord = this->get_cell_coord(position);
+            auto nb = this->get_cell_view().gather(
+                coord.row, coord.col, stencils::von_neumann
+            );
+            for (int i = 0; i < 4; ++i) {
+                Cell *cell = nb[i];
+                if (!cell) continue;
+                bool is_door = cell->item.is_door();
+                CellCoord nb_coord = {
+                    .row = coord.row + stencils::von_neumann.d_rows[i],
+                    .col = coord.col + stencils::von_neumann.d_cols[i]};
+                auto wall_type = this->get_wall_type(nb_coord);
+                if (i % 2 == 0) {
+                    if (is_door && wall_type == WallType::VERTICAL) return false;
+                } else {
+                    if (is_door && wall_type == WallType::HORIZONTAL) return false;
+                }
+            }
+            return true;
+        }
+        case ItemType::DOOR: {
+            if (cell->item.type != ItemType::WALL) return false;
+            if (this->get_wall_type(position) != WallType::NONE) return true;
+            return false;
+        }
+        case ItemType::NONE: return false;
+        default: return false;
+    }
+}
+
+bool World::place_item(const Item *item, Vector2 position) {
+    if (!this->can_place_item(item, position)) return false;
+
+    this->set_cell_item(this->get_cell_coord(position), *item);
+    return true;
+}
+
+uint32_t World::place_items(const Item *item, const std::vector<CellCoord> &coords) {
+    uint32_t n_placed = 0;
+    for (CellCoord coord : coords) {
+        if (!this->can_place_item(item, this->get_cell_position(coord))) continue;
+
+        // Journal indexes run over the layers one after the other
+        GridLayer layer = get_item_layer(item->type);
+        uint32_t idx = (uint32_t)layer * this->n_rows * this->n_cols
+                       + this->get_cell_idx(coord);
+        uint32_t old_type = (uint32_t)this->get_layer_item_type(coord, layer);
+        this->journal.record(idx, old_type, (uint32_t)item->type);
+        this->set_cell_item(coord, *item);
+        n_placed += 1;
+    }
+
+    return n_placed;
+}
+
+void World::commit_edits() {
+    this->journal.commit();
+}
+
+bool World::undo() {
+    static thread_local std::vector<EditJournal::Edit> edits;
+    if (!this->journal.undo(edits)) return false;
+
+    this->apply_edits(edits);
+    return true;
+}
+
+bool World::redo() {
+    static thread_local std::vector<EditJournal::Edit> edits;
+    if (!this->journal.redo(edits)) return false;
+
+    this->apply_edits(edits);
+    return true;
+}
+
+void World::apply_edits(const std::vector<EditJournal::Edit> &edits) {
+    // Journaled edits were valid when made, they're written back unchecked.
+    // The sprites come from the autotiling on the flush
+    uint32_t n_cells = this->n_rows * this->n_cols;
+    for (const EditJournal::Edit &edit : edits) {
+        GridLayer layer = (GridLayer)(edit.idx / n_cells);
+        uint32_t idx = edit.idx % n_cells;
+        CellCoord coord = {
+            .row = (int32_t)(idx / this->n_cols), .col = (int32_t)(idx % this->n_cols)};
+        if (layer == GridLayer::WALL) {
+            this->set_cell_item(coord, Item((ItemType)edit.new_value, 0));
+        } else {
+            this->set_cell_tile(coord, layer, (ItemType)edit.new_value);
+        }
+    }
+}
+
+std::vector<CellCoord> World::get_line_coords(CellCoord start, CellCoord end) {
+    // Bresenham, both ends included
+    std::vector<CellCoord> coords;
+    int32_t d_col = std::abs(end.col - start.col);
+    int32_t d_row = -std::abs(end.row - start.row);
+    int32_t step_col = start.col < end.col ? 1 : -1;
+    int32_t step_row = start.row < end.row ? 1 : -1;
+    int32_t error = d_col + d_row;
+
+    CellCoord coord = start;
+    while (true) {
+        coords.push_back(coord);
+        if (coord.row == end.row && coord.col == end.col) break;
+
+        int32_t error2 = 2 * error;
+        if (error2 >= d_row) {
+            error += d_row;
+            coord.col += step_col;
+        }
+        if (error2 <= d_col) {
+            error += d_col;
+            coord.row += step_row;
+        }
+    }
+
+    return coords;
+}
+
+bool World::is_door_open(const Animation_C &animation) {
+    return animation.clip_idx == this->door_clips.horizontal_open
+           || animation.clip_idx == this->door_clips.vertical_open;
+}
+
+void World::set_cell_item(CellCoord coord, const Item &item) {
+    GridLayer layer = get_item_layer(item.type);
+    if (layer != GridLayer::WALL) {
+        this->set_cell_tile(coord, layer, item.type);
+        return;
+    }
+
+    Cell *cell = this->get_cell(coord);
+    if (!cell) return;
+
+    entt::entity entity = this->cell_entities.get(coord);
+    if (entity != entt::null) {
+        this->registry.destroy(entity);
+        this->cell_entities.erase(coord);
+    }
+
+    cell->item = item;
+    this->cell_changes.mark(coord.row, coord.col);
+
+    switch (cell->item.type) {
+        case the_shell::ItemType::DOOR: {
+            entt::entity entity = this->registry.create();
+            this->registry.emplace<Door_C>(entity);
+            this->registry.emplace<Cell_C>(entity, coord);
+            this->registry.emplace<Animation_C>(
+                entity, Animation_C{this->door_clips.horizontal_closed, this->time}
+            );
+            this->cell_entities.insert(coord, entity);
+            this->is_cell_pool_sorted = false;
+        } break;
+        default: break;
+    }
+}
+
+void World::set_cell_tile(CellCoord coord, GridLayer layer, ItemType item_type) {
+    TileLayer *tiles = this->find_tile_layer(layer);
+    if (!tiles) return;
+
+    if (tiles->set(coord.row, coord.col, (uint8_t)item_type)) {
+        this->cell_changes.mark(coord.row, coord.col);
+    }
+}
+
+ItemType World::get_layer_item_type(CellCoord coord, GridLayer layer) {
+    if (layer == GridLayer::WALL) {
+        Cell *cell = this->get_cell(coord);
+        return cell ? cell->item.type : ItemType::NONE;
+    }
+
+    return (ItemType)this->find_tile_layer(layer)->get(coord.row, coord.col);
+}
+
+const TileLayer *World::get_tile_layer(GridLayer layer) {
+    return this->find_tile_layer(layer);
+}
+
+uint32_t World::get_wall_chunk_version(uint32_t chunk_row, uint32_t chunk_col) {
+    uint32_t n_chunk_cols = this->floor_layer.get_n_chunk_cols();
+    return this->wall_chunk_versions[chunk_row * n_chunk_cols + chunk_col];
+}
+
+TileLayer *World::find_tile_layer(GridLayer layer) {
+    switch (layer) {
+        case GridLayer::FLOOR: return &this->floor_layer;
+        case GridLayer::ROOF: return &this->roof_layer;
+        case GridLayer::OVERLAY: return &this->overlay_layer;
+        case GridLayer::WALL: return nullptr;
+    }
+    return nullptr;
+}
+
+void World::flush_changes() {
+    this->cell_changes.flush(this->thread_pool, min_parallel_flush_n_cells);
+}
+
+bool World::is_cell_occluder(CellCoord coord, Item &item) {
+    // Doors keep the state the door systems have picked, the new ones start
+    // closed
+    if (!item.is_door()) return item.is_wall();
+
+    entt::entity entity = this->cell_entities.get(coord);
+    if (entity == entt::null) return true;
+    return !this->is_door_open(this->registry.get<Animation_C>(entity));
+}
+
+void World::autotile(const CellRect &rect) {
+    // Sprites depend on the orthogonal neighbors, so the ring around the
+    // region is refreshed too
+    int32_t row0 = std::max(rect.row0 - 1, 0);
+    int32_t col0 = std::max(rect.col0 - 1, 0);
+    int32_t row1 = std::min(rect.row1 + 1, (int32_t)this->n_rows - 1);
+    int32_t col1 = std::min(rect.col1 + 1, (int32_t)this->n_cols - 1);
+    // The wall sprites of every chunk touched may change
+    uint32_t n_chunk_cols = this->floor_layer.get_n_chunk_cols();
+    for (uint32_t row = row0 / tile_chunk_size; row <= row1 / tile_chunk_size; ++row) {
+        for (uint32_t col = col0 / tile_chunk_size; col <= col1 / tile_chunk_size;
+             ++col) {
+            this->wall_chunk_versions[row * n_chunk_cols + col] += 1;
+        }
+    }
+
+    this->get_cell_view().for_each(
+        rect.row0 - 1,
+        rect.col0 - 1,
+        rect.row1 + 1,
+        rect.col1 + 1,
+        stencils::von_neumann,
+        [](int32_t, int32_t, Cell *cell, const std::array<Cell *, 4> &orthos) {
+            cell->item.sprite_idx = get_item_sprite_idx(cell->item.type, cell, orthos);
+        }
+    );
+}
+
+Terrain World::get_item_terrain(ItemType item_type) {
+    switch (item_type) {
+        case ItemType::WALL: return Terrain::WALL;
+        case ItemType::DOOR: return Terrain::DOOR;
+        default: return Terrain::FLOOR;
+    }
+}
+
+bool World::raycast(Vector2 start, Vector2 end, GridRayHit *hit) {
+    // Light occluders are exactly the ray blockers: walls and closed doors
+    this->flush_changes();
+    Rectangle world_rect = this->get_world_rect();
+    return cast_grid_ray(
+        this->wall_segments.get_occluders(),
+        {world_rect.x, world_rect.y},
+        start,
+        end,
+        hit
+    );
+}
+
+void World::raycast(
+    const std::vector<Segment> &rays,
+    std::vector<uint8_t> &is_hits,
+    std::vector<GridRayHit> &hits
+) {
+    this->flush_changes();
+    const GridMask &occluders = this->wall_segments.get_occluders();
+    Rectangle world_rect = this->get_world_rect();
+    Vector2 origin = {world_rect.x, world_rect.y};
+
+    is_hits.resize(rays.size());
+    hits.resize(rays.size());
+    this->thread_pool.parallel_for(
+        rays.size(),
+        min_system_chunk_size,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                is_hits[i] = cast_grid_ray(
+                    occluders, origin, rays[i].start, rays[i].end, &hits[i]
+                );
+            }
+        }
+    );
+}
+
+std::vector<CellCoord> World::find_path(CellCoord start, CellCoord goal) {
+    if (!this->is_in_grid(start) || !this->is_in_grid(goal)) return {};
+    this->flush_changes();
+
+    std::vector<CellCoord> path;
+    auto idxs = this->path_graph.find_path(
+        this->get_cell_idx(start), this->get_cell_idx(goal)
+    );
+    for (uint32_t idx : idxs) {
+        int32_t row = idx / this->n_cols;
+        int32_t col = idx % this->n_cols;
+        path.push_back({.row = row, .col = col});
+    }
+
+    return path;
+}
+
+// Save planes after the item types and the sprites of the walls. Files
+// from before the tile layers only have those two
+static constexpr std::array<GridLayer, 3> saved_tile_layers = {
+    GridLayer::FLOOR, GridLayer::ROOF, GridLayer::OVERLAY};
+
+void World::save(std::string file_path) {
+    this->flush_changes();
+
+    // Filled a save chunk at a time, nothing grid-sized is built
+    uint32_t n_save_cells = save_chunk_size * save_chunk_size;
+    auto get_chunk = [&](uint32_t row0, uint32_t col0, std::vector<uint8_t> &planes) {
+        uint32_t row1 = std::min(row0 + save_chunk_size, this->n_rows);
+        uint32_t col1 = std::min(col0 + save_chunk_size, this->n_cols);
+        for (uint32_t row = row0; row < row1; ++row) {
+            for (uint32_t col = col0; col < col1; ++col) {
+                const Item &item = this->cells[row * this->n_cols + col].item;
+                uint32_t j = (row - row0) * save_chunk_size + (col - col0);
+                planes[j] = (uint8_t)item.type;
+                planes[n_save_cells + j] = item.sprite_idx;
+                for (uint32_t k = 0; k < saved_tile_layers.size(); ++k) {
+                    const TileLayer *tiles = this->find_tile_layer(saved_tile_layers[k]);
+                    planes[(2 + k) * n_save_cells + j] = tiles->get(row, col);
+                }
+            }
+        }
+    };
+
+    Vector2 player_position = this->registry.get<Position_C>(this->player);
+    json state = {
+        {"time", this->time},
+        {"player_position", {player_position.x, player_position.y}}};
+
+    save_grid_file(
+        file_path,
+        this->n_rows,
+        this->n_cols,
+        save_chunk_size,
+        2 + saved_tile_layers.size(),
+        get_chunk,
+        json::to_msgpack(state)
+    );
+}
+
+// Whether a saved plane value is an item type of the layer, or none
+static bool is_layer_item_type(uint8_t value, GridLayer layer) {
+    // ZONE is the last item type
+    if (value > (uint8_t)ItemType::ZONE) return false;
+
+    ItemType item_type = (ItemType)value;
+    return item_type == ItemType::NONE || get_item_layer(item_type) == layer;
+}
+
+void World::load(std::string file_path) {
+    GridFile file(file_path);
+    uint32_t n_planes = file.get_n_planes();
+    if (file.get_n_rows() != this->n_rows || file.get_n_cols() != this->n_cols
+        || (n_planes != 2 && n_planes != 2 + saved_tile_layers.size())) {
+        throw std::runtime_error("Grid file doesn't match the world: " + file_path);
+    }
+
+    // Everything is decoded and checked before the first write, so a
+    // corrupted file leaves the world as it was
+    float time;
+    Vector2 player_position;
+    try {
+        json state = json::from_msgpack(file.get_blob());
+        time = state.at("time").get<float>();
+        player_position = {
+            state.at("player_position").at(0).get<float>(),
+            state.at("player_position").at(1).get<float>()};
+    } catch (const json::exception &) {
+        throw std::runtime_error("Invalid grid file state: " + file_path);
+    }
+
+    uint32_t chunk_size = file.get_chunk_size();
+    uint32_t n_chunk_cells = chunk_size * chunk_size;
+    uint32_t n_tile_planes = n_planes - 2;
+
+    // Decoded once, the checked planes are the ones applied. Empty chunks
+    // stay empty vectors
+    std::vector<std::vector<uint8_t>> chunk_planes(file.get_n_chunks());
+    for (uint32_t chunk_idx = 0; chunk_idx < file.get_n_chunks(); ++chunk_idx) {
+        if (file.is_chunk_empty(chunk_idx)) continue;
+
+        std::vector<uint8_t> &planes = chunk_planes[chunk_idx];
+        file.decode_chunk(chunk_idx, planes);
+        for (uint32_t i = 0; i < n_chunk_cells; ++i) {
+            bool is_valid = is_layer_item_type(planes[i], GridLayer::WALL);
+            for (uint32_t k = 0; k < n_tile_planes; ++k) {
+                is_valid &= is_layer_item_type(
+                    planes[(2 + k) * n_chunk_cells + i], saved_tile_layers[k]
+                );
+            }
+            if (!is_valid) {
+                throw std::runtime_error("Invalid item type in grid file: " + file_path);
+            }
+        }
+    }
+
+    this->time = time;
+    this->registry.replace<Position_C>(this->player, player_position);
+
+    // Only the cells which differ are rewritten, so the derived grids are
+    // repaired locally
+    for (uint32_t chunk_idx = 0; chunk_idx < file.get_n_chunks(); ++chunk_idx) {
+        uint32_t row0 = file.get_chunk_row(chunk_idx);
+        uint32_t col0 = file.get_chunk_col(chunk_idx);
+        uint32_t n_rows = std::min(chunk_size, this->n_rows - row0);
+        uint32_t n_cols = std::min(chunk_size, this->n_cols - col0);
+        bool is_empty = file.is_chunk_empty(chunk_idx);
+        const std::vector<uint8_t> &planes = chunk_planes[chunk_idx];
+
+        for (uint32_t row = 0; row < n_rows; ++row) {
+            for (uint32_t col = 0; col < n_cols; ++col) {
+                CellCoord coord = {
+                    .row = (int32_t)(row0 + row), .col = (int32_t)(col0 + col)};
+                uint32_t i = row * chunk_size + col;
+
+                for (uint32_t k = 0; k < saved_tile_layers.size(); ++k) {
+                    ItemType tile_type = ItemType::NONE;
+                    if (!is_empty && k < n_tile_planes) {
+                        tile_type = (ItemType)planes[(2 + k) * n_chunk_cells + i];
+                    }
+                    this->set_cell_tile(coord, saved_tile_layers[k], tile_type);
+                }
+
+                Cell *cell = this->get_cell(coord);
+                ItemType type = is_empty ? ItemType::NONE : (ItemType)planes[i];
+                uint32_t sprite_idx = is_empty ? 0 : planes[n_chunk_cells + i];
+                if (cell->item.type != type) {
+                    this->set_cell_item(coord, Item(type, sprite_idx));
+                }
+                cell->item.sprite_idx = sprite_idx;
+            }
+        }
+
+        // Applied, the peak stays at the decoded chunks not applied yet
+        std::vector<uint8_t>().swap(chunk_planes[chunk_idx]);
+    }
+
+    this->journal.clear();
+    this->is_dragging = false;
+    this->flush_changes();
+}
+
+float World::get_wall_distance(Vector2 position) {
+    return this->wall_distances.get_distance(position);
+}
+
+Vector2 World::get_wall_gradient(Vector2 position) {
+    return this->wall_distances.get_gradient(position);
+}
+
+uint32_t World::room_of(CellCoord coord) {
+    if (!this->is_in_grid(coord)) return RoomGraph::no_room;
+    this->flush_changes();
+    return this->rooms.room_of(this->get_cell_idx(coord));
+}
+
+const RoomGraph &World::get_rooms() {
+    this->flush_changes();
+    return this->rooms;
+}
+
+uint32_t World::suggest_item_sprite_idx(CellCoord coord, ItemType item_type) {
+    GridView<Cell> view = this->get_cell_view();
+    Cell *cell = view.get(coord.row, coord.col);
+    if (!cell) return get_item_sprite_idx(item_type, nullptr, {});
+
+    return get_item_sprite_idx(
+        item_type, cell, view.gather(coord.row, coord.col, stencils::von_neumann)
+    );
+}
+
+uint32_t World::suggest_item_sprite_idx(Vector2 position, ItemType item_type) {
+    return this->suggest_item_sprite_idx(this->get_cell_coord(position), item_type);
+}
+
+}  // namespace the_shell
@@ -0,0 +1,407 @@
+#pragma once
+
+#include "core/animation.hpp"
+#include "core/collision_layer.hpp"
+#include "core/distance_field.hpp"
+#include "core/edit_journal.hpp"
+#include "core/flow_field.hpp"
+#include "core/fov.hpp"
+#include "core/grid_changes.hpp"
+#include "core/grid_mask.hpp"
+#include "core/grid_ray.hpp"
+#include "core/grid_view.hpp"
+#include "core/path_graph.hpp"
+#include "core/room_graph.hpp"
+#include "core/wall_segments.hpp"
+#include "core/scheduler.hpp"
+#include "core/terrain.hpp"
+#include "core/thread_pool.hpp"
+#include "core/tile_layer.hpp"
+#include "entt/container/dense_map.hpp"
+#include "entt/entity/entity.hpp"
+#include "entt/entity/fwd.hpp"
+#include "entt/entt.hpp"
+#include "raylib.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace the_shell {
+// -----------------------------------------------------------------------
+// constants
+static constexpr uint32_t grid_n_rows = 100;
+static constexpr uint32_t grid_n_cols = 100;
+static const float door_open_dist = 2.0;
+static constexpr uint32_t min_system_chunk_size = 256;
+static const float nav_door_cost = 2.0;
+static constexpr uint32_t max_n_flow_fields = 16;
+static constexpr uint32_t nav_cluster_size = 16;
+static constexpr uint32_t collision_chunk_size = 16;
+static constexpr uint32_t distance_chunk_size = 16;
+static constexpr uint32_t change_chunk_size = 16;
+static constexpr uint32_t tile_chunk_size = 16;
+static constexpr uint32_t min_parallel_flush_n_cells = 1024;
+static const float max_wall_dist = 8.0;
+static constexpr uint32_t max_journal_n_bytes = 1 << 20;
+static constexpr uint32_t save_chunk_size = 32;
+static const float player_light_radius = 10.0;
+static constexpr Color player_light_color = {255, 230, 180, 40};
+
+// -----------------------------------------------------------------------
+// sheet indexes
+namespace sheet_0 {
+static constexpr uint32_t wall = 1;
+static constexpr uint32_t door = 17;
+}  // namespace sheet_0
+
+// -----------------------------------------------------------------------
+// animation clips, resolved from the sheet frame tags
+struct DoorClips {
+    uint32_t horizontal_closed;
+    uint32_t horizontal_open;
+    uint32_t vertical_closed;
+    uint32_t vertical_open;
+};
+
+// -----------------------------------------------------------------------
+// enums
+enum class WallType {
+    NONE,
+    HORIZONTAL,
+    VERTICAL,
+};
+
+enum class ItemType {
+    NONE,
+    WALL,
+    DOOR,
+    FLOOR,
+    ROOF,
+    ZONE,
+};
+
+// Layers of the grid, in the draw order. Every item type lives on one of
+// them. The walls and doors are the cells' items, the other layers are
+// tile planes of their own (the tile is the item type)
+enum class GridLayer {
+    FLOOR,
+    WALL,
+    ROOF,
+    OVERLAY,
+};
+static constexpr uint32_t n_grid_layers = 4;
+
+GridLayer get_item_layer(ItemType item_type);
+
+// -----------------------------------------------------------------------
+// item
+class Item {
+public:
+    ItemType type = ItemType::NONE;
+    uint32_t sprite_idx = 0;
+
+    Item();
+    Item(ItemType type, uint32_t sprite_idx);
+
+    bool is_none();
+    bool is_wall();
+    bool is_door();
+    bool is_wall_or_door();
+};
+
+// -----------------------------------------------------------------------
+// cell
+// Storage-independent cell handle: stays valid whatever the grid layout is
+struct CellCoord {
+    int32_t row;
+    int32_t col;
+
+    uint64_t get_key() const;
+};
+
+// Bidirectional cell <-> entity index. The entity -> cell direction is the
+// Cell_C component, this one maps the other way without touching the grid
+class CellEntityIndex {
+private:
+    entt::dense_map<uint64_t, entt::entity> entities;
+
+public:
+    void insert(CellCoord coord, entt::entity entity);
+    void erase(CellCoord coord);
+    entt::entity get(CellCoord coord) const;
+};
+
+// The position of a cell follows from its coord, see get_cell_position()
+class Cell {
+public:
+    Item item;
+};
+
+// Scheduler resource of the wall sprite versions, which are a plain vector
+struct WallChunkVersions {};
+
+class CellNeighbors {
+public:
+    std::array<Cell *, 8> cells;
+
+    CellNeighbors();
+
+    std::array<Cell *, 4> get_orthos();
+};
+
+// -----------------------------------------------------------------------
+// components
+struct Position_C : public Vector2 {
+    Position_C(const Vector2 &vec)
+        : Vector2{vec.x, vec.y} {}
+};
+
+struct Cell_C : public CellCoord {
+    Cell_C(const CellCoord &coord)
+        : CellCoord{coord.row, coord.col} {}
+};
+
+struct Door_C {};
+struct Animation_C {
+    uint32_t clip_idx;
+    float start_time;
+};
+struct ResolveCollision_C {};
+
+// Cells the entity sees from its own cell, recomputed every tick
+struct Vision_C {
+    uint32_t radius;
+    FieldOfView fov;
+};
+
+// Light source, walls and closed doors cast shadows. The polygon is the lit
+// region, recomputed every tick
+struct Light_C {
+    float radius;
+    Color color;
+    std::vector<Vector2> polygon;
+};
+
+// Moves the entity along the flow field towards the goal cell
+struct FollowFlow_C {
+    CellCoord goal;
+    float speed;
+    bool can_open_doors;
+};
+
+// -----------------------------------------------------------------------
+// input
+// Everything the simulation reads from the outside during one tick
+struct Input {
+    float dt = 0.0;
+
+    Vector2 mouse_position_world = {0.0, 0.0};
+
+    bool is_lmb_down = false;
+    bool is_ui_interacted = false;
+
+    bool is_undo_pressed = false;
+    bool is_redo_pressed = false;
+
+    bool is_w_down = false;
+    bool is_s_down = false;
+    bool is_a_down = false;
+    bool is_d_down = false;
+
+    int active_item_idx = -1;
+};
+
+// -----------------------------------------------------------------------
+// world
+class World {
+private:
+    ThreadPool &thread_pool;
+    AnimationTable &animation_table;
+    Scheduler scheduler;
+    DoorClips door_clips;
+
+    Input input;
+
+    // Cell under the cursor on the previous tick of a placement drag
+    CellCoord drag_coord = {0, 0};
+    bool is_dragging = false;
+
+    // Placements, a whole drag stroke is one action
+    EditJournal journal;
+    float time = 0.0;
+
+    // -------------------------------------------------------------------
+    // grid
+    uint32_t n_rows;
+    uint32_t n_cols;
+    std::vector<Cell> cells;
+    CellEntityIndex cell_entities;
+    bool is_cell_pool_sorted = true;
+
+    // Cells written since the last flush_changes(), everything below (and
+    // the sprites) is derived from the cells and catches up on the flush
+    GridChanges cell_changes;
+
+    // Cells which block the line of sight: walls and doors
+    GridMask opaque_cells;
+
+    // Light occluders outline: walls and closed doors
+    WallSegments wall_segments;
+
+    // Merged rects of the walls, doors collide per cell as they open
+    CollisionLayer wall_colliders;
+
+    // Signed distance to the walls and closed doors
+    DistanceField wall_distances;
+
+    // Floor regions enclosed by walls and doors
+    RoomGraph rooms;
+
+    // The layers other than the walls: nothing is derived from them, they
+    // only track their dirty chunks for the render caches. Their writes go
+    // through the change bus like the cells', its flush publishes them
+    TileLayer floor_layer;
+    TileLayer roof_layer;
+    TileLayer overlay_layer;
+
+    // Version of the wall sprites per tile chunk, bumped by the autotiling
+    // (the door animation frames don't count), like the tile layers'
+    std::vector<uint32_t> wall_chunk_versions;
+
+    // -------------------------------------------------------------------
+    // navigation
+    FlowFieldCache flow_fields;
+    PathGraph path_graph;
+
+    TileLayer *find_tile_layer(GridLayer layer);
+
+    // -------------------------------------------------------------------
+    // update
+    void update_active_item_placement();
+    void update_grid_changes();
+    void update_player();
+    void update_path_graph();
+    void update_flow_fields();
+    void update_flow_followers();
+    void update_visions();
+    void update_doors();
+    void update_lights();
+    void update_animations();
+    void update_wall_colliders();
+    void update_wall_distances();
+    void update_collisions();
+
+    // -------------------------------------------------------------------
+    // grid change subscribers
+    // func(coord, idx, item) for every cell of the flushed rects
+    template <typename Func>
+    void subscribe_cell_changes(Func func);
+    bool is_cell_occluder(CellCoord coord, Item &item);
+    void autotile(const CellRect &rect);
+
+public:
+    entt::registry registry;
+    entt::entity player;
+    std::vector<Item> items;
+
+    World(const World &) = delete;
+    World &operator=(const World &) = delete;
+
+    World(
+        uint32_t n_rows,
+        uint32_t n_cols,
+        ThreadPool &thread_pool,
+        AnimationTable &animation_table
+    );
+
+    void update(const Input &input);
+    std::vector<SystemTiming> get_system_timings();
+
+    Item *get_item(int item_idx);
+
+    Rectangle get_world_rect();
+    Rectangle get_occupied_rect(Vector2 position);
+    CellCoord get_cell_coord(Vector2 position);
+    Vector2 get_cell_position(CellCoord coord);
+    bool is_in_grid(CellCoord coord);
+
+    // nullptr out of the grid
+    Cell *get_cell(CellCoord coord);
+    Cell *get_cell(Vector2 position);
+    uint32_t get_cell_idx(CellCoord coord);
+    GridView<Cell> get_cell_view();
+    CellNeighbors get_cell_neighbors(Vector2 position);
+    WallType get_wall_type(CellCoord coord);
+    WallType get_wall_type(Vector2 position);
+    Vector2 round_position(Vector2 position);
+    bool can_place_item(const Item *item, Vector2 position);
+    bool place_item(const Item *item, Vector2 position);
+
+    // Places the item on every cell where can_place_item allows it, in
+    // order (earlier cells count for the later checks). Returns the number
+    // of placed items. The placements are journaled until commit_edits()
+    uint32_t place_items(const Item *item, const std::vector<CellCoord> &coords);
+    void commit_edits();
+    bool undo();
+    bool redo();
+    std::vector<CellCoord> get_line_coords(CellCoord start, CellCoord end);
+    bool is_door_open(const Animation_C &animation);
+
+    // Item change on the item's layer (ItemType::NONE clears the walls).
+    // The door entities are updated right away, the derived grids and the
+    // sprites on the next flush_changes()
+    void set_cell_item(CellCoord coord, const Item &item);
+
+    // Tile change on a layer other than the walls, ItemType::NONE clears it
+    void set_cell_tile(CellCoord coord, GridLayer layer, ItemType item_type);
+
+    // What the layer holds on the cell, NONE out of the grid
+    ItemType get_layer_item_type(CellCoord coord, GridLayer layer);
+
+    // nullptr for the walls, which are the cells' items
+    const TileLayer *get_tile_layer(GridLayer layer);
+    uint32_t get_wall_chunk_version(uint32_t chunk_row, uint32_t chunk_col);
+
+    // Brings the derived grids and the sprites up to date with the cell
+    // writes, merged into a few dirty rects. Runs once per tick after the
+    // placements, the queries which read the derived grids call it too
+    void flush_changes();
+    void apply_edits(const std::vector<EditJournal::Edit> &edits);
+    Terrain get_item_terrain(ItemType item_type);
+
+    // Hitscan: the first wall or closed door the segment crosses, open doors
+    // let it through. The door states are the ones of the last update
+    bool raycast(Vector2 start, Vector2 end, GridRayHit *hit);
+
+    // One query per ray on the thread pool, is_hits[i] tells whether
+    // hits[i] is set
+    void raycast(
+        const std::vector<Segment> &rays,
+        std::vector<uint8_t> &is_hits,
+        std::vector<GridRayHit> &hits
+    );
+
+    // Point-to-point route over the hierarchical path graph, cells from
+    // start to goal (both included), empty if the goal is unreachable
+    std::vector<CellCoord> find_path(CellCoord start, CellCoord goal);
+
+    // Grid items and the player in a chunked grid file. The door entities
+    // are rebuilt from the cells, the grid size must match on load.
+    // Both throw on I/O errors
+    void save(std::string file_path);
+    void load(std::string file_path);
+
+    // Clearance: signed distance to the nearest wall or closed door edge,
+    // clamped to max_wall_dist. The gradient points away from them
+    float get_wall_distance(Vector2 position);
+    Vector2 get_wall_gradient(Vector2 position);
+
+    // Room of the floor cell, RoomGraph::no_room for walls, doors and cells
+    // out of the grid
+    uint32_t room_of(CellCoord coord);
+    const RoomGraph &get_rooms();
+    uint32_t suggest_item_sprite_idx(CellCoord coord, ItemType item_type);
+    uint32_t suggest_item_sprite_idx(Vector2 position, ItemType item_type);
+};
+}  // namespace the_shell